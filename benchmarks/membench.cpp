@@ -0,0 +1,66 @@
+// Measures CPU bus read/write throughput per memory region.
+//
+// Usage: membench <rom> [accesses per region]
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+
+#include "Bus.hpp"
+#include "FrameSink.hpp"
+
+struct Region
+{
+	const char* Name;
+	Word Base;
+	Word Mask;	//< Accesses are spread over Base + (0 ... Mask)
+	bool Write;
+};
+
+static const Region Regions[] = {
+	{ "zeropage read",		0x0000, 0x00FF, false },
+	{ "zeropage write",		0x0000, 0x00FF, true },
+	{ "stack read",			0x0100, 0x00FF, false },
+	{ "stack write",		0x0100, 0x00FF, true },
+	{ "RAM mirror read",	0x1800, 0x07FF, false },
+	{ "RAM mirror write",	0x1800, 0x07FF, true },
+	{ "PRG ROM read",		0x8000, 0x7FFF, false },
+	{ "IO read $4015",		0x4015, 0x0000, false },
+};
+
+// Reads are summed up into this, so the compiler can't drop them
+static volatile Byte Sink;
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <rom> [accesses per region]\n", argv[0]);
+		return 2;
+	}
+
+	uint32_t accesses = (argc > 2) ? (uint32_t)strtoul(argv[2], nullptr, 10) : 100000000;
+
+	FrameSink screen;
+	Bus bus(argv[1], &screen);
+
+	for (const Region& region : Regions)
+	{
+		Byte sum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < accesses; i++)
+		{
+			Word addr = region.Base + ((i * 7) & region.Mask);
+			if (region.Write)
+				bus.WriteCPU(addr, (Byte)i);
+			else
+				sum += bus.ReadCPU(addr);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		Sink = sum;
+
+		printf("%-18s %8.1f M accesses/s\n", region.Name, accesses / seconds / 1e6);
+	}
+
+	return 0;
+}
@@ -0,0 +1,148 @@
+// Measures the PPU on a sprite-heavy scene and checks that both renderers draw it the same.
+//
+// The scene is a generated ROM whose CPU only runs an endless loop. 64 sprites are
+// arranged in 8 clusters, so 128 scanlines (8x16 sprites) or 64 scanlines (8x8 sprites)
+// have the maximum of 8 sprites each, over a filled background. The fine X scroll changes
+// every 7 frames.
+//
+// Usage: spritebench [frames]
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Bus.hpp"
+#include "FrameSink.hpp"
+#include "HeadlessRunner.hpp"
+
+/**
+ * @brief Write an NROM image with an idle loop and pseudo-random pattern tables.
+ */
+static void WriteSceneROM(const std::string& path)
+{
+	Header header{};
+	header.Signature[0] = 'N';
+	header.Signature[1] = 'E';
+	header.Signature[2] = 'S';
+	header.Signature[3] = 0x1A;
+	header.PrgROM = 1;
+	header.ChrROM = 1;
+	header.Flag6.Mirroring = 1;
+
+	// $8000: JMP $8000, and every vector points there
+	std::vector<Byte> prg(0x4000, 0xEA);
+	prg[0] = 0x4C;
+	prg[1] = 0x00;
+	prg[2] = 0x80;
+	for (size_t vector = 0x3FFA; vector < 0x4000; vector += 2)
+	{
+		prg[vector] = 0x00;
+		prg[vector + 1] = 0x80;
+	}
+
+	std::vector<Byte> chr(0x2000);
+	uint32_t seed = 0x12345678;
+	for (Byte& byte : chr)
+	{
+		seed = seed * 1664525 + 1013904223;
+		byte = (Byte)(seed >> 24);
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)prg.data(), prg.size());
+	file.write((const char*)chr.data(), chr.size());
+}
+
+/**
+ * @brief Fill OAM, the nametables and the palettes through the PPU registers and turn rendering on.
+ */
+static void SetUpScene(Bus& bus, bool tallSprites)
+{
+	bus.WriteCPU(0x2003, 0x00);
+	for (int i = 0; i < 64; i++)
+	{
+		bus.WriteCPU(0x2004, (Byte)((i / 8) * 28 + (i % 3)));
+		bus.WriteCPU(0x2004, (Byte)((i * 7) & 0xFF));
+		bus.WriteCPU(0x2004, (Byte)((i * 0x25) & 0xE3));
+		bus.WriteCPU(0x2004, (Byte)((i * 37) % 248));
+	}
+
+	bus.WriteCPU(0x2006, 0x20);
+	bus.WriteCPU(0x2006, 0x00);
+	for (int i = 0; i < 0x800; i++)
+		bus.WriteCPU(0x2007, (Byte)((i * 13) & 0xFF));
+
+	bus.WriteCPU(0x2006, 0x3F);
+	bus.WriteCPU(0x2006, 0x00);
+	for (int i = 0; i < 0x20; i++)
+		bus.WriteCPU(0x2007, (Byte)((i * 5) & 0x3F));
+
+	bus.WriteCPU(0x2000, tallSprites ? 0x20 : 0x00);
+	bus.WriteCPU(0x2005, 0x00);
+	bus.WriteCPU(0x2005, 0x00);
+	bus.WriteCPU(0x2001, 0x1E);
+}
+
+/**
+ * @brief Run the scene and return a hash over all frames.
+ */
+static uint32_t RunScene(const std::string& rom, uint64_t frames, bool tallSprites, bool scanlineRenderer)
+{
+	FrameSink screen;
+	Bus bus(rom.c_str(), &screen);
+	bus.EnableScanlineRenderer(scanlineRenderer);
+
+	// Let the PPU warm up before touching its registers
+	bus.Frame();
+	bus.Frame();
+	SetUpScene(bus, tallSprites);
+
+	uint32_t hash = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t frame = 0; frame < frames; frame++)
+	{
+		if (frame % 7 == 0)
+		{
+			bus.WriteCPU(0x2005, (Byte)(frame & 7));
+			bus.WriteCPU(0x2005, 0x00);
+		}
+
+		bus.Frame();
+		hash = hash * 31 + HeadlessRunner::HashFrame(screen.GetPixels());
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%s sprites, %-8s renderer: %8.1f fps, hash %08x\n", tallSprites ? "8x16" : "8x8 ", scanlineRenderer ? "scanline" : "dot", frames / seconds, hash);
+	return hash;
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t frames = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 2000;
+
+	std::string rom = (std::filesystem::temp_directory_path() / "spritebench.nes").string();
+	WriteSceneROM(rom);
+
+	bool identical = true;
+	for (bool tallSprites : { false, true })
+	{
+		uint32_t scanline = RunScene(rom, frames, tallSprites, true);
+		uint32_t dot = RunScene(rom, frames, tallSprites, false);
+		identical &= (scanline == dot);
+	}
+
+	std::filesystem::remove(rom);
+
+	if (!identical)
+	{
+		printf("FAIL: the renderers drew different frames\n");
+		return 1;
+	}
+
+	return 0;
+}
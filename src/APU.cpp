@@ -1,6 +1,7 @@
 #include "APU.hpp"
 
 #include "Bus.hpp"
+#include "SaveState.hpp"
 
 APU::APU(Bus* bus) :
 	bus(bus)
@@ -59,3 +60,21 @@ void APU::WriteRegister(Word addr, Byte val)
 	} break;
 	}
 }
+
+void APU::Serialize(SaveState& state) const
+{
+	state.Write(sequencer);
+	state.Write(mode);
+	state.Write(disableInterrupt);
+	state.Write(cycles);
+	state.Write(APUActionLatch);
+}
+
+void APU::Deserialize(SaveState& state)
+{
+	state.Read(sequencer);
+	state.Read(mode);
+	state.Read(disableInterrupt);
+	state.Read(cycles);
+	state.Read(APUActionLatch);
+}
@@ -3,6 +3,7 @@
 #include "Types.hpp"
 
 class Bus;
+class SaveState;
 
 class APU
 {
@@ -16,6 +17,9 @@ public:
 
 	void WriteRegister(Word addr, Byte val);
 
+	void Serialize(SaveState& state) const;
+	void Deserialize(SaveState& state);
+
 private:
 	uint64_t sequencer = 0;
 	bool mode = false;
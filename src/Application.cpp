@@ -13,6 +13,7 @@
 #include "Screen.hpp"
 #include "Debugger.hpp"
 #include "gfx/Window.hpp"
+#include "gfx/Input.hpp"
 
 void Application::Launch(const char* rom)
 {
@@ -93,7 +94,8 @@ Application::Application(const char* rom) :
 		throw err;
 	}
 
-	bus = new Bus(rom, screen);
+	input = new KeyboardInput(window);
+	bus = new Bus(rom, screen, input);
 	debugger = new Debugger(bus);
 }
 
@@ -104,6 +106,7 @@ Application::~Application()
 	if(bus)
 		delete bus;
 
+	delete input;
 	delete window;
 }
 
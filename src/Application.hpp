@@ -6,6 +6,7 @@ class Bus;
 class Window;
 class Debugger;
 class Screen;
+class InputSource;
 
 /**
  * @brief Contains the program loop and invokes other objects update functions.
@@ -34,6 +35,7 @@ private:
 	Window* window;
 	Bus* bus;
 	Screen* screen;
+	InputSource* input;
 	Debugger* debugger;
 
 	std::chrono::steady_clock::time_point lastFrameTime;
@@ -2,27 +2,27 @@
 #include "Log.hpp"
 
 #include <stdexcept>
+#include <string>
 
 #include "controllers/StandardController.hpp"
 
-Bus::Bus(const char* rom, Screen* screen) :
-	cpu(this), ppu(this, screen), apu(this), cartridge(this)
+Bus::Bus(const char* rom, FrameSink* screen, InputSource* input) :
+	cpu(this), ppu(this, screen), apu(this), cartridge(this), input(input)
 {
-	LOG_CORE_INFO("Allocating RAM");
-	RAM = std::vector<Byte>(0x800);
-
-	LOG_CORE_INFO("Allocating VRAM");
-	VRAM = std::vector<Byte>(0x800);
-	palettes = std::vector<Byte>(0x20, 0);
+	// Embedders don't have to set up logging themselves
+	Log::Init();
 
 	LOG_CORE_INFO("Inserting cartridge");
 	cartridge.Load(rom);
+	MapMemory();
 
 	LOG_CORE_INFO("Powering up CPU");
 	cpu.Powerup();
+	scheduler.Schedule(Scheduler::Event::CPU, 3 * cpu.GetRemainingCycles());
 
 	LOG_CORE_INFO("Powering up PPU");
 	ppu.Powerup();
+	ScheduleVBlank();
 
 	LOG_CORE_INFO("Powering up APU");
 	apu.Powerup();
@@ -30,11 +30,40 @@ Bus::Bus(const char* rom, Screen* screen) :
 	controllerPort.PlugInController<StandardController>(0);
 }
 
+Bus::Bus(Bus& other, FrameSink* screen, InputSource* input) :
+	cpu(this), ppu(this, screen), apu(this), cartridge(this, other.cartridge), controllerPort(other.controllerPort), input(input)
+{
+	MapMemory();
+
+	// The save state covers all of the mutable state, the ROM is already shared by the cartridge
+	SaveState state;
+	other.Snapshot(state);
+	Restore(state);
+
+	ppu.EnableScanlineRenderer(other.ppu.IsScanlineRendererEnabled());
+	ppu.SetFrameSkip(other.ppu.GetFrameSkip());
+	ppu.SetOutputEnabled(other.ppu.IsOutputEnabled());
+	bulkDMA = other.bulkDMA;
+}
+
+std::unique_ptr<Bus> Bus::Clone(FrameSink* screen, InputSource* input)
+{
+	return std::unique_ptr<Bus>(new Bus(*this, screen, input));
+}
+
 void Bus::Reboot()
 {
 	cpu.Powerup();
 	ppu.Powerup();
 	apu.Powerup();
+
+	scheduler.Clear();
+	if (DMACyclesLeft != 0)
+		scheduler.Schedule(Scheduler::Event::DMA, NextCycle());
+	else
+		scheduler.Schedule(Scheduler::Event::CPU, NextCycle() + 3 * cpu.GetRemainingCycles());
+
+	ScheduleVBlank();
 }
 
 void Bus::Reset()
@@ -42,34 +71,204 @@ void Bus::Reset()
 	cpu.Reset();
 	ppu.Reset();
 	apu.Reset();
+
+	ScheduleVBlank();
+}
+
+void Bus::Snapshot(SaveState& state)
+{
+	// Lazily run components are part of the state too
+	CatchUpAPU();
+	CatchUpPPU();
+
+	state.Clear();
+	state.Write(SaveState::Magic);
+	state.Write(SaveState::Version);
+
+	// The cartridge comes first, so a state for a different one is rejected before anything is changed
+	cartridge.Serialize(state);
+	cpu.Serialize(state);
+	ppu.Serialize(state);
+	apu.Serialize(state);
+	controllerPort.Serialize(state);
+
+	state.Write(RAM);
+	state.Write(VRAM);
+	state.Write(palettes);
+
+	state.Write(preDMACycles);
+	state.Write(DMACyclesLeft);
+	state.Write(DMAPage);
+	state.Write(DMALatch);
+
+	scheduler.Serialize(state);
+	state.Write(masterClock);
+	state.Write(ppuClock);
+	state.Write(apuCycles);
+	state.Write(nextVBlank);
 }
 
-uint8_t Bus::Tick()
+void Bus::Restore(SaveState& state)
 {
-	controllerPort.Tick();
+	// Components are overwritten one after another, so keep the current state in case a later one is broken
+	Snapshot(rollback);
 
-	uint8_t result = 0x00;
-	if (DMACyclesLeft == 0)
+	try
 	{
-		result = cpu.Tick();
+		Load(state);
 	}
-	else
+	catch (...)
+	{
+		Load(rollback);
+		throw;
+	}
+}
+
+void Bus::Load(SaveState& state)
+{
+	state.Rewind();
+
+	uint32_t magic, version;
+	state.Read(magic);
+	state.Read(version);
+	if (magic != SaveState::Magic)
+		throw std::runtime_error("Not a save state");
+	if (version != SaveState::Version)
+		throw std::runtime_error("Unsupported save state version " + std::to_string(version));
+
+	cartridge.Deserialize(state);
+	cpu.Deserialize(state);
+	ppu.Deserialize(state);
+	apu.Deserialize(state);
+	controllerPort.Deserialize(state);
+
+	state.Read(RAM);
+	state.Read(VRAM);
+	state.Read(palettes);
+
+	state.Read(preDMACycles);
+	state.Read(DMACyclesLeft);
+	state.Read(DMAPage);
+	state.Read(DMALatch);
+
+	scheduler.Deserialize(state);
+	state.Read(masterClock);
+	state.Read(ppuClock);
+	state.Read(apuCycles);
+	state.Read(nextVBlank);
+
+	if (!state.IsAtEnd())
+		throw std::runtime_error("Save state is too long");
+
+	// Rebuild everything that is derived from the restored state
+	ppu.ResolvePalette();
+	MapPRG();
+}
+
+void Bus::Tick()
+{
+	RunUntil(masterClock % 3 ? NextCycle() : masterClock + 3);
+}
+
+void Bus::RunUntil(uint64_t timestamp)
+{
+	while (scheduler.NextTimestamp() < timestamp)
+		Process(scheduler.Pop());
+
+	// Leave everything in a consistent state for the outside world
+	masterClock = timestamp;
+	CatchUpAPU();
+	CatchUpPPU();
+}
+
+void Bus::Process(const Scheduler::ScheduledEvent& event)
+{
+	masterClock = event.Timestamp;
+	CatchUpAPU();
+
+	switch (event.Type)
+	{
+	case Scheduler::Event::VBlank:
+	{
+		// Events from before a PPU reset are outdated
+		if (event.Timestamp != nextVBlank + 1)
+			break;
+
+		// This sends the NMI if necessary
+		CatchUpPPU();
+		ScheduleVBlank();
+
+		// Input is sampled once per frame
+		if (input != nullptr)
+			controllerPort.SetInput(input->Sample());
+	} break;
+
+	case Scheduler::Event::CPU:
+	{
+		uint8_t cycles = 0;
+		try
+		{
+			cycles = cpu.Step();
+		}
+		catch (const std::runtime_error&)
+		{
+			// Keep the CPU scheduled so it can be halted
+			scheduler.Schedule(Scheduler::Event::CPU, event.Timestamp + 3);
+			throw;
+		}
+
+		// OAM DMA suspends the CPU right after the instruction that started it
+		if (DMACyclesLeft != 0)
+			scheduler.Schedule(Scheduler::Event::DMA, event.Timestamp + 3);
+		else
+			scheduler.Schedule(Scheduler::Event::CPU, event.Timestamp + 3 * (cycles ? cycles : 1));
+	} break;
+
+	case Scheduler::Event::DMA:
 	{
-		DMATick();
-		result = (uint8_t)DMACyclesLeft;
+		uint32_t cycles = BulkDMA();
+		if (cycles == 0)
+		{
+			DMATick();
+			cycles = 1;
+		}
+
+		// The CPU continues with the rest of its instruction afterwards
+		if (DMACyclesLeft != 0)
+			scheduler.Schedule(Scheduler::Event::DMA, event.Timestamp + 3);
+		else
+			scheduler.Schedule(Scheduler::Event::CPU, event.Timestamp + 3 * cycles + 3 * cpu.GetRemainingCycles());
+	} break;
 	}
+}
 
+void Bus::CatchUpPPU()
+{
+	if (ppuClock < masterClock)
+	{
+		ppu.Run(masterClock - ppuClock);
+		ppuClock = masterClock;
+	}
+}
 
-	// 3 ppu ticks per cpu tick
-	ppu.Tick();
-	ppu.Tick();
-	ppu.Tick();
+void Bus::CatchUpAPU()
+{
+	// The APU is ticked at the end of every CPU cycle. It is only
+	// active every 2 cycles, but that logic is handled inside the APU class
+	while (apuCycles < masterClock / 3)
+	{
+		apu.Tick();
+		apuCycles++;
+	}
+}
 
-	// APU is only ticked every 2 cycles, but that logic
-	// is handled inside the APU class
-	apu.Tick();
+void Bus::ScheduleVBlank()
+{
+	CatchUpPPU();
 
-	return result;
+	// The event comes right after the dot that starts VBlank
+	nextVBlank = ppuClock + ppu.DotsUntilVBlank();
+	scheduler.Schedule(Scheduler::Event::VBlank, nextVBlank + 1);
 }
 
 void Bus::DMATick()
@@ -83,6 +282,7 @@ void Bus::DMATick()
 	if (DMALatch != 0)
 	{
 		Byte data = ReadCPU(((Word)DMAPage << 8) | (0x100 - DMACyclesLeft));
+		CatchUpPPU();
 		ppu.WriteRegister(0x04, data);
 
 		DMACyclesLeft--;
@@ -91,23 +291,44 @@ void Bus::DMATick()
 	DMALatch = 1 - DMALatch;
 }
 
-void Bus::PPUTick()
+uint32_t Bus::BulkDMA()
 {
-	if (ppuClock == 0)
-	{
-		cpu.Tick();
-		apu.Tick();
-	}
+	// Only whole transfers that haven't started yet, reading from RAM or ROM (no side effects)
+	const Byte* page = readPages[DMAPage];
+	if (!bulkDMA || DMACyclesLeft != 0x100 || DMALatch != 0 || page == nullptr)
+		return 0;
+
+	// The PPU must not evaluate sprites or reset OAMADDR while the DMA is running
+	uint32_t cycles = preDMACycles + 2 * DMACyclesLeft;
+	CatchUpPPU();
+	if (ppu.IdleDotsAhead() < 3 * cycles)
+		return 0;
+
+	ppu.WriteOAMPage(page);
+
+	preDMACycles = 0;
+	DMACyclesLeft = 0;
+	return cycles;
+}
 
-	ppu.Tick();
-	ppuClock = (ppuClock + 1) % 3;
+void Bus::PPUTick()
+{
+	RunUntil(masterClock + 1);
 }
 
 bool Bus::Instruction()
 {
 	try
 	{
-		while (Tick());
+		// Run until the CPU has started its next instruction, and only that one
+		Scheduler::ScheduledEvent event;
+		do
+		{
+			event = scheduler.Pop();
+			Process(event);
+		} while (event.Type != Scheduler::Event::CPU);
+
+		RunUntil(event.Timestamp + 3);
 	}
 	catch (const std::runtime_error& err)
 	{
@@ -123,8 +344,12 @@ bool Bus::Frame()
 {
 	try
 	{
+		// Run to the end of the cycle the PPU finishes the frame in
 		while (!ppu.IsFrameDone())
-			Tick();
+		{
+			uint64_t frameDone = masterClock + ppu.DotsUntilVBlank() + 1;
+			RunUntil(frameDone + (3 - frameDone % 3) % 3);
+		}
 	}
 	catch (const std::runtime_error& err)
 	{
@@ -136,20 +361,37 @@ bool Bus::Frame()
 	return true;
 }
 
-Byte Bus::ReadCPU(Word addr)
+void Bus::MapMemory()
 {
-	if (0x0000 <= addr && addr < 0x2000)
+	readPages.fill(nullptr);
+	writePages.fill(nullptr);
+
+	// 2KB of RAM, mirrored up to $1FFF
+	for (Word page = 0x00; page < 0x20; page++)
 	{
-		return RAM[addr & 0x7FF];
+		readPages[page] = RAM.data() + ((page & 0x7) << 8);
+		writePages[page] = RAM.data() + ((page & 0x7) << 8);
 	}
-	else if (0x2000 <= addr && addr < 0x4000)
+
+	MapPRG();
+}
+
+void Bus::MapPRG()
+{
+	// PRG RAM is read and written directly. PRG ROM is read-only, writes to it go to the mapper registers
+	const Mapper* mapper = cartridge.GetMapper();
+	std::copy(mapper->GetPRGPages().begin(), mapper->GetPRGPages().end(), readPages.begin() + (Mapper::PRGStart >> 8));
+	std::copy(mapper->GetPRGWritePages().begin(), mapper->GetPRGWritePages().end(), writePages.begin() + (Mapper::PRGStart >> 8));
+	mappedPRGConfiguration = mapper->GetPRGBankConfiguration();
+}
+
+Byte Bus::ReadRegister(Word addr)
+{
+	if (0x2000 <= addr && addr < 0x4000)
 	{
+		CatchUpPPU();
 		return ppu.ReadRegister(addr & 0x7);
 	}
-	else if (0x8000 <= addr && addr <= 0xFFFF)
-	{
-		return cartridge.ReadCPU(addr);
-	}
 	else if (0x4000 <= addr && addr <= 0x4017)
 	{
 		switch (addr)
@@ -192,19 +434,22 @@ Byte Bus::ReadPPU(Word addr)
 	return 0x00;
 }
 
-void Bus::WriteCPU(Word addr, Byte val)
+void Bus::WriteRegister(Word addr, Byte val)
 {
-	if (0x0000 <= addr && addr < 0x2000)
-	{
-		RAM[addr & 0x7FF] = val;
-	}
-	else if (0x2000 <= addr && addr < 0x4000)
+	if (0x2000 <= addr && addr < 0x4000)
 	{
+		CatchUpPPU();
 		ppu.WriteRegister(addr & 0x7, val);
 	}
 	else if (0x8000 <= addr && addr <= 0xFFFF)
 	{
+		// Mappers can switch CHR banks and mirroring
+		CatchUpPPU();
 		cartridge.WriteCPU(addr, val);
+
+		// The mapper might have switched banks
+		if (cartridge.GetMapper()->GetPRGBankConfiguration() != mappedPRGConfiguration)
+			MapPRG();
 	}
 	else if (0x4000 <= addr && addr <= 0x4017)
 	{
@@ -248,5 +493,6 @@ void Bus::WritePPU(Word addr, Byte val)
 			addr &= 0xF;
 
 		palettes[addr & 0x1F] = val;
+		ppu.ResolvePalette();
 	}
 }
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <array>
+#include <memory>
+#include <algorithm>
 
 #include "Types.hpp"
 #include "CPU.hpp"
@@ -8,6 +11,8 @@
 #include "APU.hpp"
 #include "Cartridge.hpp"
 #include "ControllerPort.hpp"
+#include "Scheduler.hpp"
+#include "SaveState.hpp"
 
 /**
  * @brief The main bus for hardware to communicate.
@@ -25,7 +30,20 @@ class Bus
 	friend class Palettes;
 
 public:
-	Bus(const char* rom, Screen* screen);
+	/**
+	 * @brief Insert a ROM and power up the NES.
+	 * The input source is optional, without one the buttons have to be set through SetInput()
+	 */
+	Bus(const char* rom, FrameSink* screen, InputSource* input = nullptr);
+	Bus(const Bus&) = delete;
+	Bus& operator=(const Bus&) = delete;
+
+	/**
+	 * @brief Create an independent copy of the machine, e.g. to try out different inputs from here.
+	 * The copy shares the ROM with this machine and copies everything else, including the
+	 * settings. It draws into its own frame sink, the frame buffer itself isn't copied
+	 */
+	std::unique_ptr<Bus> Clone(FrameSink* screen, InputSource* input = nullptr);
 
 	/**
 	 * @brief Reboot the NES.
@@ -42,15 +60,43 @@ public:
 	 */
 	void Reset();
 
+	/**
+	 * @brief Save the state of the whole machine (see SaveState).
+	 * The frame buffer isn't part of the state, so snapshots are usually taken between frames
+	 */
+	void Snapshot(SaveState& state);
+
+	/**
+	 * @brief Restore a state saved by Snapshot().
+	 * Throws if the state is from a different version or cartridge, truncated or contains invalid
+	 * values. The machine is left untouched then
+	 */
+	void Restore(SaveState& state);
+
 	/**
 	 * @brief Advance the emulator by one CPU cycle (and 3 PPU cycles).
 	 */
-	uint8_t Tick();
+	void Tick();
 
 	void DMATick();
 
+	/**
+	 * @brief Allow OAM DMA to be done as a single copy when nothing can observe it.
+	 * Disabling this makes every transfer happen on its own cycle, e.g. for single stepping
+	 */
+	inline void EnableBulkDMA(bool enable) { bulkDMA = enable; }
+
+	/**
+	 * @brief Advance the emulator by one PPU cycle.
+	 */
 	void PPUTick();
 
+	/**
+	 * @brief Run all components up to the given master clock timestamp.
+	 * Events before the timestamp are handled, the PPU only catches up when needed
+	 */
+	void RunUntil(uint64_t timestamp);
+
 	/**
 	 * @brief Advance the emulator by one CPU instruction.
 	 */
@@ -62,20 +108,77 @@ public:
 	 */
 	bool Frame();
 
+	/**
+	 * @brief Only draw one out of every given number of frames (see PPU::SetFrameSkip()).
+	 */
+	inline void SetFrameSkip(uint32_t frames) { ppu.SetFrameSkip(frames); }
+	inline uint32_t GetFrameSkip() const { return ppu.GetFrameSkip(); }
+
+	/**
+	 * @brief Check whether the frame finished by the last call to Frame() was drawn.
+	 */
+	inline bool WasLastFrameDrawn() const { return ppu.WasLastFrameDrawn(); }
+
+	/**
+	 * @brief Switch between the scanline and the dot renderer (see PPU::EnableScanlineRenderer()).
+	 */
+	inline void EnableScanlineRenderer(bool enable) { ppu.EnableScanlineRenderer(enable); }
+
+	/**
+	 * @brief Turn pixel output on or off (see PPU::SetOutputEnabled()).
+	 */
+	inline void SetOutputEnabled(bool enable) { ppu.SetOutputEnabled(enable); }
+
+	/**
+	 * @brief Set the buttons the controllers report until the next call.
+	 */
+	inline void SetInput(const InputState& state) { controllerPort.SetInput(state); }
+
+	/**
+	 * @brief Check whether the CPU stopped executing, e.g. after an unknown opcode.
+	 */
+	inline bool IsHalted() const { return cpu.IsHalted(); }
+
+	inline uint64_t GetExecutedInstructions() const { return cpu.GetExecutedInstructions(); }
+
 	/**
 	 * @brief Read call from the CPU
+	 * Memory is looked up in the page table, only registers need to be handled separately
 	 */
-	Byte ReadCPU(Word addr);
+	inline Byte ReadCPU(Word addr)
+	{
+		const Byte* page = readPages[addr >> 8];
+		if (page != nullptr)
+			return page[addr & 0xFF];
+
+		return ReadRegister(addr);
+	}
 
 	/**
 	 * @brief Read call from the PPU
 	 */
 	Byte ReadPPU(Word addr);
 
+	/**
+	 * @brief Read a decoded tile row from the pattern tables ($0000-$1FFF).
+	 */
+	inline const TileCache::Row& ReadTileRow(Word addr) { return cartridge.ReadTileRow(addr); }
+
 	/**
 	 * @brief Write call from the CPU
+	 * Memory is looked up in the page table, only registers need to be handled separately
 	 */
-	void WriteCPU(Word addr, Byte val);
+	inline void WriteCPU(Word addr, Byte val)
+	{
+		Byte* page = writePages[addr >> 8];
+		if (page != nullptr)
+		{
+			page[addr & 0xFF] = val;
+			return;
+		}
+
+		WriteRegister(addr, val);
+	}
 
 	/**
 	 * @brief Write call from the PPU
@@ -88,19 +191,103 @@ public:
 	inline void NMI() { cpu.NMI(); }
 	inline void IRQ() { cpu.IRQ(); }
 
+	/**
+	 * @brief Lets the CPU check if its decoded instructions are still valid.
+	 */
+	inline uint32_t GetPRGBankConfiguration() { return cartridge.GetMapper()->GetPRGBankConfiguration(); }
+
+private:
+	/**
+	 * @brief Copy another machine (see Clone()).
+	 */
+	Bus(Bus& other, FrameSink* screen, InputSource* input);
+
+	/**
+	 * @brief Read a state saved by Snapshot() into the machine.
+	 * Throws on broken states, the machine can be half overwritten then (see Restore())
+	 */
+	void Load(SaveState& state);
+
+	/**
+	 * @brief Advance the master clock to an event and handle it.
+	 */
+	void Process(const Scheduler::ScheduledEvent& event);
+
+	/**
+	 * @brief Run the PPU up to the master clock.
+	 * The PPU is only synchronized when something depends on its state
+	 */
+	void CatchUpPPU();
+
+	/**
+	 * @brief Run the APU up to the master clock.
+	 */
+	void CatchUpAPU();
+
+	/**
+	 * @brief Try to do the whole pending OAM DMA at once.
+	 * Only possible if the source page is memory and the PPU stays idle until the DMA is over.
+	 * Returns the number of CPU cycles the DMA takes, or 0 if it has to run cycle by cycle
+	 */
+	uint32_t BulkDMA();
+
+	/**
+	 * @brief Schedule the event for the next start of VBlank.
+	 */
+	void ScheduleVBlank();
+
+	/**
+	 * @brief Timestamp of the next CPU cycle boundary.
+	 */
+	inline uint64_t NextCycle() const { return masterClock + (3 - masterClock % 3) % 3; }
+
+	/**
+	 * @brief Set up the CPU page table.
+	 */
+	void MapMemory();
+
+	/**
+	 * @brief Copy the PRG pages of the mapper into the CPU page table.
+	 */
+	void MapPRG();
+
+	/**
+	 * @brief Handle CPU reads that aren't backed by memory.
+	 */
+	Byte ReadRegister(Word addr);
+
+	/**
+	 * @brief Handle CPU writes that aren't backed by memory.
+	 */
+	void WriteRegister(Word addr, Byte val);
+
 private:
-	std::vector<Byte> RAM, VRAM;
-	std::vector<Byte> palettes;
+	std::array<Byte, 0x800> RAM{};
+	std::array<Byte, 0x800> VRAM{};
+	std::array<Byte, 0x20> palettes{};
 	CPU cpu;
 	PPU ppu;
 	APU apu;
 	Cartridge cartridge;
 	ControllerPort controllerPort;
+	InputSource* input;
+
+	// Pages (256 bytes each) of the CPU address space, nullptr means the access is handled by a register
+	std::array<const Byte*, 0x100> readPages{};
+	std::array<Byte*, 0x100> writePages{};
+	uint32_t mappedPRGConfiguration = 0;
 
 	Byte preDMACycles = 0;
 	Word DMACyclesLeft = 0;
 	Byte DMAPage = 0;
 	Byte DMALatch = 0;
+	bool bulkDMA = true;
+
+	Scheduler scheduler;
+	uint64_t masterClock = 0;	//< Current time in PPU dots
+	uint64_t ppuClock = 0;		//< Number of dots the PPU has run so far
+	uint64_t apuCycles = 0;		//< Number of CPU cycles the APU has run so far
+	uint64_t nextVBlank = 0;	//< Timestamp of the dot that starts the next VBlank
 
-	uint8_t ppuClock = 0;
+	SaveState rollback;	//< State before the last Restore(), loaded again if the restored state was broken
 };
@@ -1,22 +1,21 @@
 ﻿#include "CPU.hpp"
 
 #include <iomanip>
+#include <algorithm>
 
 #include "Bus.hpp"
 #include "Log.hpp"
+#include "SaveState.hpp"
 
-#define BIND(x) (std::bind(&CPU::x, this))
-#define NEW_INSTRUCTION(op, addr, size, cyc) Instruction{ BIND(op), BIND(addr), Addressing::addr, size, cyc, " " #op }
-#define NEW_ILLGL_INSTR(op, addr, size, cyc) Instruction{ BIND(op), BIND(addr), Addressing::addr, size, cyc, "*" #op }
+#define NEW_INSTRUCTION(op, addr, size, cyc) Instruction{ &CPU::op, Addressing::addr, size, cyc, " " #op }
+#define NEW_ILLGL_INSTR(op, addr, size, cyc) Instruction{ &CPU::op, Addressing::addr, size, cyc, "*" #op }
 
-#define CHECK_NEGATIVE(x)	status.Flag.Negative = (((x) & 0x80) == 0x80)
-#define CHECK_ZERO(x)		status.Flag.Zero = ((x) == 0x00)
+#define CHECK_NEGATIVE(x)	negativeResult = (Byte)(x)
+#define CHECK_ZERO(x)		zeroResult = (Byte)(x)
 
 CPU::CPU(Bus* bus) :
-	bus(bus)
+	decodeCache(0x8000), bus(bus)
 {
-	LOG_CORE_INFO("Creating instruction lookup table");
-	CreateInstructionTable();
 }
 
 Byte CPU::Read(Word addr)
@@ -29,315 +28,417 @@ void CPU::Write(Word addr, Byte val)
 	bus->WriteCPU(addr, val);
 }
 
+void CPU::SetStatus(Byte raw)
+{
+	status.Raw = raw;
+	negativeResult = raw;
+	zeroResult = status.Flag.Zero ? 0x00 : 0x01;
+	carry = status.Flag.Carry;
+}
+
 void CPU::FetchValue()
 {
-	if (currentInstruction->AddrType != Addressing::ACC && currentInstruction->AddrType != Addressing::IMP)
+	// Implied instructions never fetch a value, accumulator and immediate values are already there
+	if (!valueFetched)
 		fetchedVal = Read(absoluteAddress.Raw);
 }
 
-uint8_t CPU::Tick()
+uint8_t CPU::Step()
 {
 	if (halted)
 		return 0;
 
-	// If there are still cycles left from last instruction, dont do anything
-	totalCycles++;
-	if (remainingCycles)
-	{
-		return remainingCycles--;
-	}
+	// The cycles of the last instruction have passed by now
+	totalCycles += remainingCycles + 1;
 
-	// Get current opcode and instruction
-	Byte opcode = Read(pc.Raw++);
-	currentInstruction = &(InstructionTable[opcode]);
+	uint8_t cycles = Execute(Fetch(pc.Raw));
+	remainingCycles = cycles - 1;
+	return cycles;
+}
+
+uint8_t CPU::Execute(const DecodedInstruction& instruction)
+{
+	currentInstruction = &(InstructionTable[instruction.Opcode]);
+	executedInstructions++;
 
 	// Add this instruction to the past instruction list
-	pastInstructions.push_back(std::make_pair((Word)(pc.Raw - 1), currentInstruction));
+	Word address = pc.Raw;
+	pastInstructions.push_back(std::make_pair(address, currentInstruction));
 	if (pastInstructions.size() > 50)
 		pastInstructions.pop_front();
 
+	pc.Raw += instruction.Size;
+
 	// If the instruction is not set in the lookup table, abort
-	if (currentInstruction->Opcode == nullptr || currentInstruction->Mode == nullptr)
+	if (instruction.Execute == nullptr)
 	{
-		LOG_DEBUG_ERROR("Unknown instruction {0:02X} at ${1:04X}", opcode, pc.Raw);
+		LOG_DEBUG_ERROR("Unknown instruction {0:02X} at ${1:04X}", instruction.Opcode, address);
 		throw std::runtime_error("Encountered unknown opcode");
 	}
 
 	// Invoke addressing mode and instruction
+	// The instruction might invalidate its own cache entry, so read everything before
+	uint8_t cycles = instruction.Cycles;
+	operand = instruction.Operand;
 	accumulatorAddressing = false;
-	currentInstruction->Mode();
-	currentInstruction->Opcode();
+	valueFetched = false;
+	instruction.Execute(*this);
 
-	// Set remaining cycles
-	remainingCycles = currentInstruction->Cycles + additionalCycles;
+	cycles += additionalCycles;
 	additionalCycles = 0;
-	remainingCycles--;
-	return 0;
-}
-
-void CPU::CreateInstructionTable()
-{
-	InstructionTable[0x00] = NEW_INSTRUCTION(BRK, IMP, 1, 7);
-	InstructionTable[0x01] = NEW_INSTRUCTION(ORA, IDX, 2, 6);
-	InstructionTable[0x03] = NEW_ILLGL_INSTR(SLO, IDX, 2, 8);
-	InstructionTable[0x04] = NEW_ILLGL_INSTR(NOP, ZPG, 2, 3);
-	InstructionTable[0x05] = NEW_INSTRUCTION(ORA, ZPG, 2, 3);
-	InstructionTable[0x06] = NEW_INSTRUCTION(ASL, ZPG, 2, 5);
-	InstructionTable[0x07] = NEW_ILLGL_INSTR(SLO, ZPG, 2, 5);
-	InstructionTable[0x08] = NEW_INSTRUCTION(PHP, IMP, 1, 3);
-	InstructionTable[0x09] = NEW_INSTRUCTION(ORA, IMM, 2, 2);
-	InstructionTable[0x0A] = NEW_INSTRUCTION(ASL, ACC, 1, 2);
-	InstructionTable[0x0B] = NEW_ILLGL_INSTR(ANC, IMM, 2, 2);
-	InstructionTable[0x0D] = NEW_INSTRUCTION(ORA, ABS, 3, 4);
-	InstructionTable[0x0C] = NEW_ILLGL_INSTR(NOP, ABS, 3, 4);
-	InstructionTable[0x0E] = NEW_INSTRUCTION(ASL, ABS, 3, 6);
-	InstructionTable[0x0F] = NEW_ILLGL_INSTR(SLO, ABS, 3, 6);
-
-	InstructionTable[0x10] = NEW_INSTRUCTION(BPL, REL, 2, 2);
-	InstructionTable[0x11] = NEW_INSTRUCTION(ORA, IDY, 2, 5);
-	InstructionTable[0x13] = NEW_ILLGL_INSTR(SLO, IDY, 2, 8);
-	InstructionTable[0x14] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
-	InstructionTable[0x15] = NEW_INSTRUCTION(ORA, ZPX, 2, 4);
-	InstructionTable[0x16] = NEW_INSTRUCTION(ASL, ZPX, 2, 6);
-	InstructionTable[0x17] = NEW_ILLGL_INSTR(SLO, ZPX, 2, 6);
-	InstructionTable[0x18] = NEW_INSTRUCTION(CLC, IMP, 1, 2);
-	InstructionTable[0x19] = NEW_INSTRUCTION(ORA, ABY, 3, 4);
-	InstructionTable[0x1A] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
-	InstructionTable[0x1B] = NEW_ILLGL_INSTR(SLO, ABY, 3, 7);
-	InstructionTable[0x1C] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
-	InstructionTable[0x1D] = NEW_INSTRUCTION(ORA, ABX, 3, 4);
-	InstructionTable[0x1E] = NEW_INSTRUCTION(ASL, ABX, 3, 7);
-	InstructionTable[0x1F] = NEW_ILLGL_INSTR(SLO, ABX, 3, 7);
-
-
-	InstructionTable[0x20] = NEW_INSTRUCTION(JSR, ABS, 3, 6);
-	InstructionTable[0x21] = NEW_INSTRUCTION(AND, IDX, 2, 6);
-	InstructionTable[0x23] = NEW_ILLGL_INSTR(RLA, IDX, 2, 8);
-	InstructionTable[0x24] = NEW_INSTRUCTION(BIT, ZPG, 2, 3);
-	InstructionTable[0x25] = NEW_INSTRUCTION(AND, ZPG, 2, 3);
-	InstructionTable[0x26] = NEW_INSTRUCTION(ROL, ZPG, 2, 5);
-	InstructionTable[0x27] = NEW_ILLGL_INSTR(RLA, ZPG, 2, 5);
-	InstructionTable[0x28] = NEW_INSTRUCTION(PLP, IMP, 1, 4);
-	InstructionTable[0x29] = NEW_INSTRUCTION(AND, IMM, 2, 2);
-	InstructionTable[0x2A] = NEW_INSTRUCTION(ROL, ACC, 1, 2);
-	InstructionTable[0x2B] = NEW_ILLGL_INSTR(ANC, IMM, 2, 2);
-	InstructionTable[0x2C] = NEW_INSTRUCTION(BIT, ABS, 3, 4);
-	InstructionTable[0x2D] = NEW_INSTRUCTION(AND, ABS, 3, 4);
-	InstructionTable[0x2E] = NEW_INSTRUCTION(ROL, ABS, 3, 6);
-	InstructionTable[0x2F] = NEW_ILLGL_INSTR(RLA, ABS, 3, 6);
-
-	InstructionTable[0x30] = NEW_INSTRUCTION(BMI, REL, 2, 2);
-	InstructionTable[0x31] = NEW_INSTRUCTION(AND, IDY, 2, 5);
-	InstructionTable[0x33] = NEW_ILLGL_INSTR(RLA, IDY, 2, 8);
-	InstructionTable[0x34] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
-	InstructionTable[0x35] = NEW_INSTRUCTION(AND, ZPX, 2, 4);
-	InstructionTable[0x36] = NEW_INSTRUCTION(ROL, ZPX, 2, 6);
-	InstructionTable[0x37] = NEW_ILLGL_INSTR(RLA, ZPX, 2, 6);
-	InstructionTable[0x38] = NEW_INSTRUCTION(SEC, IMP, 1, 2);
-	InstructionTable[0x39] = NEW_INSTRUCTION(AND, ABY, 3, 4);
-	InstructionTable[0x3A] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
-	InstructionTable[0x3B] = NEW_ILLGL_INSTR(RLA, ABY, 3, 7);
-	InstructionTable[0x3C] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
-	InstructionTable[0x3D] = NEW_INSTRUCTION(AND, ABX, 3, 4);
-	InstructionTable[0x3E] = NEW_INSTRUCTION(ROL, ABX, 3, 7);
-	InstructionTable[0x3F] = NEW_ILLGL_INSTR(RLA, ABX, 3, 7);
-
-	InstructionTable[0x40] = NEW_INSTRUCTION(RTI, IMP, 1, 6);
-	InstructionTable[0x41] = NEW_INSTRUCTION(EOR, IDX, 2, 6);
-	InstructionTable[0x43] = NEW_ILLGL_INSTR(SRE, IDX, 2, 8);
-	InstructionTable[0x44] = NEW_ILLGL_INSTR(NOP, ZPG, 2, 3);
-	InstructionTable[0x45] = NEW_INSTRUCTION(EOR, ZPG, 2, 3);
-	InstructionTable[0x46] = NEW_INSTRUCTION(LSR, ZPG, 2, 5);
-	InstructionTable[0x47] = NEW_ILLGL_INSTR(SRE, ZPG, 2, 5);
-	InstructionTable[0x48] = NEW_INSTRUCTION(PHA, IMP, 1, 3);
-	InstructionTable[0x49] = NEW_INSTRUCTION(EOR, IMM, 2, 2);
-	InstructionTable[0x4A] = NEW_INSTRUCTION(LSR, ACC, 1, 2);
-	InstructionTable[0x4B] = NEW_ILLGL_INSTR(ALR, IMM, 2, 2);
-	InstructionTable[0x4C] = NEW_INSTRUCTION(JMP, ABS, 3, 3);
-	InstructionTable[0x4D] = NEW_INSTRUCTION(EOR, ABS, 3, 4);
-	InstructionTable[0x4E] = NEW_INSTRUCTION(LSR, ABS, 3, 6);
-	InstructionTable[0x4F] = NEW_ILLGL_INSTR(SRE, ABS, 3, 6);
-
-	InstructionTable[0x50] = NEW_INSTRUCTION(BVC, REL, 2, 2);
-	InstructionTable[0x51] = NEW_INSTRUCTION(EOR, IDY, 2, 5);
-	InstructionTable[0x53] = NEW_ILLGL_INSTR(SRE, IDY, 2, 8);
-	InstructionTable[0x54] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
-	InstructionTable[0x55] = NEW_INSTRUCTION(EOR, ZPX, 2, 4);
-	InstructionTable[0x56] = NEW_INSTRUCTION(LSR, ZPX, 2, 6);
-	InstructionTable[0x57] = NEW_ILLGL_INSTR(SRE, ZPX, 2, 6);
-	InstructionTable[0x58] = NEW_INSTRUCTION(CLI, IMP, 1, 2);
-	InstructionTable[0x59] = NEW_INSTRUCTION(EOR, ABY, 3, 4);
-	InstructionTable[0x5A] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
-	InstructionTable[0x5B] = NEW_ILLGL_INSTR(SRE, ABY, 3, 7);
-	InstructionTable[0x5C] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
-	InstructionTable[0x5D] = NEW_INSTRUCTION(EOR, ABX, 3, 4);
-	InstructionTable[0x5E] = NEW_INSTRUCTION(LSR, ABX, 3, 7);
-	InstructionTable[0x5F] = NEW_ILLGL_INSTR(SRE, ABX, 3, 7);
-
-	InstructionTable[0x60] = NEW_INSTRUCTION(RTS, IMP, 1, 6);
-	InstructionTable[0x61] = NEW_INSTRUCTION(ADC, IDX, 2, 6);
-	InstructionTable[0x63] = NEW_ILLGL_INSTR(RRA, IDX, 2, 8);
-	InstructionTable[0x64] = NEW_ILLGL_INSTR(NOP, ZPG, 2, 3);
-	InstructionTable[0x65] = NEW_INSTRUCTION(ADC, ZPG, 2, 3);
-	InstructionTable[0x66] = NEW_INSTRUCTION(ROR, ZPG, 2, 5);
-	InstructionTable[0x67] = NEW_ILLGL_INSTR(RRA, ZPG, 2, 5);
-	InstructionTable[0x68] = NEW_INSTRUCTION(PLA, IMP, 1, 4);
-	InstructionTable[0x69] = NEW_INSTRUCTION(ADC, IMM, 2, 2);
-	InstructionTable[0x6A] = NEW_INSTRUCTION(ROR, ACC, 1, 2);
-	InstructionTable[0x6B] = NEW_ILLGL_INSTR(ARR, IMM, 2, 2);
-	InstructionTable[0x6C] = NEW_INSTRUCTION(JMP, IND, 3, 5);
-	InstructionTable[0x6D] = NEW_INSTRUCTION(ADC, ABS, 3, 4);
-	InstructionTable[0x6E] = NEW_INSTRUCTION(ROR, ABS, 3, 6);
-	InstructionTable[0x6F] = NEW_ILLGL_INSTR(RRA, ABS, 3, 6);
-
-	InstructionTable[0x70] = NEW_INSTRUCTION(BVS, REL, 2, 2);
-	InstructionTable[0x71] = NEW_INSTRUCTION(ADC, IDY, 2, 5);
-	InstructionTable[0x73] = NEW_ILLGL_INSTR(RRA, IDY, 2, 8);
-	InstructionTable[0x74] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
-	InstructionTable[0x75] = NEW_INSTRUCTION(ADC, ZPX, 2, 4);
-	InstructionTable[0x76] = NEW_INSTRUCTION(ROR, ZPX, 2, 6);
-	InstructionTable[0x77] = NEW_ILLGL_INSTR(RRA, ZPX, 2, 6);
-	InstructionTable[0x78] = NEW_INSTRUCTION(SEI, IMP, 1, 2);
-	InstructionTable[0x79] = NEW_INSTRUCTION(ADC, ABY, 3, 4);
-	InstructionTable[0x7A] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
-	InstructionTable[0x7B] = NEW_ILLGL_INSTR(RRA, ABY, 3, 7);
-	InstructionTable[0x7C] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
-	InstructionTable[0x7D] = NEW_INSTRUCTION(ADC, ABX, 3, 4);
-	InstructionTable[0x7E] = NEW_INSTRUCTION(ROR, ABX, 3, 7);
-	InstructionTable[0x7F] = NEW_ILLGL_INSTR(RRA, ABX, 3, 7);
-
-	InstructionTable[0x80] = NEW_ILLGL_INSTR(NOP, IMM, 2, 2);
-	InstructionTable[0x81] = NEW_INSTRUCTION(STA, IDX, 2, 6);
-	InstructionTable[0x83] = NEW_ILLGL_INSTR(SAX, IDX, 2, 6);
-	InstructionTable[0x82] = NEW_ILLGL_INSTR(NOP, IMM, 2, 2);
-	InstructionTable[0x85] = NEW_INSTRUCTION(STA, ZPG, 2, 3);
-	InstructionTable[0x84] = NEW_INSTRUCTION(STY, ZPG, 2, 3);
-	InstructionTable[0x86] = NEW_INSTRUCTION(STX, ZPG, 2, 3);
-	InstructionTable[0x87] = NEW_ILLGL_INSTR(SAX, ZPG, 2, 3);
-	InstructionTable[0x88] = NEW_INSTRUCTION(DEY, IMP, 1, 2);
-	InstructionTable[0x89] = NEW_ILLGL_INSTR(NOP, IMM, 2, 2);
-	InstructionTable[0x8A] = NEW_INSTRUCTION(TXA, IMP, 1, 2);
-	InstructionTable[0x8B] = NEW_ILLGL_INSTR(ANE, IMM, 2, 2);
-	InstructionTable[0x8C] = NEW_INSTRUCTION(STY, ABS, 3, 4);
-	InstructionTable[0x8D] = NEW_INSTRUCTION(STA, ABS, 3, 4);
-	InstructionTable[0x8E] = NEW_INSTRUCTION(STX, ABS, 3, 4);
-	InstructionTable[0x8F] = NEW_ILLGL_INSTR(SAX, ABS, 2, 4);
-
-	InstructionTable[0x90] = NEW_INSTRUCTION(BCC, REL, 2, 2);
-	InstructionTable[0x91] = NEW_INSTRUCTION(STA, IDY, 2, 6);
-	InstructionTable[0x94] = NEW_INSTRUCTION(STY, ZPX, 2, 4);
-	InstructionTable[0x95] = NEW_INSTRUCTION(STA, ZPX, 2, 4);
-	InstructionTable[0x96] = NEW_INSTRUCTION(STX, ZPY, 2, 4);
-	InstructionTable[0x97] = NEW_ILLGL_INSTR(SAX, ZPY, 2, 4);
-	InstructionTable[0x98] = NEW_INSTRUCTION(TYA, IMP, 1, 2);
-	InstructionTable[0x99] = NEW_INSTRUCTION(STA, ABY, 3, 5);
-	InstructionTable[0x9A] = NEW_INSTRUCTION(TXS, IMP, 1, 2);
-	InstructionTable[0x9C] = NEW_ILLGL_INSTR(SHY, ABX, 3, 5);
-	InstructionTable[0x9D] = NEW_INSTRUCTION(STA, ABX, 3, 5);
-	InstructionTable[0x9E] = NEW_ILLGL_INSTR(SHX, ABY, 3, 5);
-
-	InstructionTable[0xA0] = NEW_INSTRUCTION(LDY, IMM, 2, 2);
-	InstructionTable[0xA1] = NEW_INSTRUCTION(LDA, IDX, 2, 6);
-	InstructionTable[0xA2] = NEW_INSTRUCTION(LDX, IMM, 2, 2);
-	InstructionTable[0xA3] = NEW_ILLGL_INSTR(LAX, IDX, 2, 6);
-	InstructionTable[0xA4] = NEW_INSTRUCTION(LDY, ZPG, 2, 3);
-	InstructionTable[0xA5] = NEW_INSTRUCTION(LDA, ZPG, 2, 3);
-	InstructionTable[0xA6] = NEW_INSTRUCTION(LDX, ZPG, 2, 3);
-	InstructionTable[0xA7] = NEW_ILLGL_INSTR(LAX, ZPG, 2, 3);
-	InstructionTable[0xA8] = NEW_INSTRUCTION(TAY, IMP, 1, 2);
-	InstructionTable[0xA9] = NEW_INSTRUCTION(LDA, IMM, 2, 2);
-	InstructionTable[0xAA] = NEW_INSTRUCTION(TAX, IMP, 1, 2);
-	InstructionTable[0xAB] = NEW_ILLGL_INSTR(LXA, IMM, 2, 2);
-	InstructionTable[0xAC] = NEW_INSTRUCTION(LDY, ABS, 3, 4);
-	InstructionTable[0xAD] = NEW_INSTRUCTION(LDA, ABS, 3, 4);
-	InstructionTable[0xAE] = NEW_INSTRUCTION(LDX, ABS, 3, 4);
-	InstructionTable[0xAF] = NEW_ILLGL_INSTR(LAX, ABS, 3, 4);
-
-	InstructionTable[0xB0] = NEW_INSTRUCTION(BCS, REL, 2, 2);
-	InstructionTable[0xB1] = NEW_INSTRUCTION(LDA, IDY, 2, 5);
-	InstructionTable[0xB3] = NEW_ILLGL_INSTR(LAX, IDY, 2, 5);
-	InstructionTable[0xB4] = NEW_INSTRUCTION(LDY, ZPX, 2, 4);
-	InstructionTable[0xB5] = NEW_INSTRUCTION(LDA, ZPX, 2, 4);
-	InstructionTable[0xB6] = NEW_INSTRUCTION(LDX, ZPY, 2, 4);
-	InstructionTable[0xB7] = NEW_ILLGL_INSTR(LAX, ZPY, 2, 4);
-	InstructionTable[0xB8] = NEW_INSTRUCTION(CLV, IMP, 1, 2);
-	InstructionTable[0xB9] = NEW_INSTRUCTION(LDA, ABY, 3, 4);
-	InstructionTable[0xBA] = NEW_INSTRUCTION(TSX, IMP, 1, 2);
-	InstructionTable[0xBC] = NEW_INSTRUCTION(LDY, ABX, 3, 4);
-	InstructionTable[0xBD] = NEW_INSTRUCTION(LDA, ABX, 3, 4);
-	InstructionTable[0xBE] = NEW_INSTRUCTION(LDX, ABY, 3, 4);
-	InstructionTable[0xBF] = NEW_ILLGL_INSTR(LAX, ABY, 3, 4);
-
-	InstructionTable[0xC0] = NEW_INSTRUCTION(CPY, IMM, 2, 2);
-	InstructionTable[0xC1] = NEW_INSTRUCTION(CMP, IDX, 2, 6);
-	InstructionTable[0xC2] = NEW_ILLGL_INSTR(NOP, IMM, 2, 2);
-	InstructionTable[0xC3] = NEW_ILLGL_INSTR(DCP, IDX, 2, 8);
-	InstructionTable[0xC4] = NEW_INSTRUCTION(CPY, ZPG, 2, 3);
-	InstructionTable[0xC5] = NEW_INSTRUCTION(CMP, ZPG, 2, 3);
-	InstructionTable[0xC6] = NEW_INSTRUCTION(DEC, ZPG, 2, 5);
-	InstructionTable[0xC7] = NEW_ILLGL_INSTR(DCP, ZPG, 2, 5);
-	InstructionTable[0xC8] = NEW_INSTRUCTION(INY, IMP, 1, 2);
-	InstructionTable[0xC9] = NEW_INSTRUCTION(CMP, IMM, 2, 2);
-	InstructionTable[0xCA] = NEW_INSTRUCTION(DEX, IMP, 1, 2);
-	InstructionTable[0xCB] = NEW_ILLGL_INSTR(SBX, IMM, 2, 2);
-	InstructionTable[0xCC] = NEW_INSTRUCTION(CPY, ABS, 3, 4);
-	InstructionTable[0xCD] = NEW_INSTRUCTION(CMP, ABS, 3, 4);
-	InstructionTable[0xCE] = NEW_INSTRUCTION(DEC, ABS, 3, 6);
-	InstructionTable[0xCF] = NEW_ILLGL_INSTR(DCP, ABS, 3, 6);
-
-	InstructionTable[0xD0] = NEW_INSTRUCTION(BNE, REL, 2, 2);
-	InstructionTable[0xD1] = NEW_INSTRUCTION(CMP, IDY, 2, 5);
-	InstructionTable[0xD3] = NEW_ILLGL_INSTR(DCP, IDY, 2, 8);
-	InstructionTable[0xD4] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
-	InstructionTable[0xD5] = NEW_INSTRUCTION(CMP, ZPX, 2, 4);
-	InstructionTable[0xD6] = NEW_INSTRUCTION(DEC, ZPX, 2, 6);
-	InstructionTable[0xD7] = NEW_ILLGL_INSTR(DCP, ZPX, 2, 6);
-	InstructionTable[0xD8] = NEW_INSTRUCTION(CLD, IMP, 1, 2);
-	InstructionTable[0xD9] = NEW_INSTRUCTION(CMP, ABY, 3, 4);
-	InstructionTable[0xDA] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
-	InstructionTable[0xDB] = NEW_ILLGL_INSTR(DCP, ABY, 3, 7);
-	InstructionTable[0xDC] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
-	InstructionTable[0xDD] = NEW_INSTRUCTION(CMP, ABX, 3, 4);
-	InstructionTable[0xDE] = NEW_INSTRUCTION(DEC, ABX, 3, 7);
-	InstructionTable[0xDF] = NEW_ILLGL_INSTR(DCP, ABX, 3, 7);
-
-	InstructionTable[0xE0] = NEW_INSTRUCTION(CPX, IMM, 2, 2);
-	InstructionTable[0xE1] = NEW_INSTRUCTION(SBC, IDX, 2, 6);
-	InstructionTable[0xE2] = NEW_ILLGL_INSTR(NOP, IMM, 2, 2);
-	InstructionTable[0xE3] = NEW_ILLGL_INSTR(ISC, IDX, 2, 8);
-	InstructionTable[0xE4] = NEW_INSTRUCTION(CPX, ZPG, 2, 3);
-	InstructionTable[0xE5] = NEW_INSTRUCTION(SBC, ZPG, 2, 3);
-	InstructionTable[0xE6] = NEW_INSTRUCTION(INC, ZPG, 2, 5);
-	InstructionTable[0xE7] = NEW_ILLGL_INSTR(ISC, ZPG, 2, 5);
-	InstructionTable[0xE8] = NEW_INSTRUCTION(INX, IMP, 1, 2);
-	InstructionTable[0xE9] = NEW_INSTRUCTION(SBC, IMM, 2, 2);
-	InstructionTable[0xEA] = NEW_INSTRUCTION(NOP, IMP, 1, 2);
-	InstructionTable[0xEB] = NEW_ILLGL_INSTR(SBC, IMM, 2, 2);
-	InstructionTable[0xEC] = NEW_INSTRUCTION(CPX, ABS, 3, 4);
-	InstructionTable[0xED] = NEW_INSTRUCTION(SBC, ABS, 3, 4);
-	InstructionTable[0xEE] = NEW_INSTRUCTION(INC, ABS, 3, 6);
-	InstructionTable[0xEF] = NEW_ILLGL_INSTR(ISC, ABS, 3, 6);
-
-	InstructionTable[0xF0] = NEW_INSTRUCTION(BEQ, REL, 2, 2);
-	InstructionTable[0xF1] = NEW_INSTRUCTION(SBC, IDY, 2, 5);
-	InstructionTable[0xF3] = NEW_ILLGL_INSTR(ISC, IDY, 2, 8);
-	InstructionTable[0xF4] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
-	InstructionTable[0xF5] = NEW_INSTRUCTION(SBC, ZPX, 2, 4);
-	InstructionTable[0xF6] = NEW_INSTRUCTION(INC, ZPX, 2, 6);
-	InstructionTable[0xF7] = NEW_ILLGL_INSTR(ISC, ZPX, 2, 6);
-	InstructionTable[0xF8] = NEW_INSTRUCTION(SED, IMP, 1, 2);
-	InstructionTable[0xF9] = NEW_INSTRUCTION(SBC, ABY, 3, 4);
-	InstructionTable[0xFA] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
-	InstructionTable[0xFB] = NEW_ILLGL_INSTR(ISC, ABY, 3, 7);
-	InstructionTable[0xFC] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
-	InstructionTable[0xFD] = NEW_INSTRUCTION(SBC, ABX, 3, 4);
-	InstructionTable[0xFE] = NEW_INSTRUCTION(INC, ABX, 3, 7);
-	InstructionTable[0xFF] = NEW_ILLGL_INSTR(ISC, ABX, 3, 7);
+	return cycles;
+}
+
+const DecodedInstruction& CPU::Fetch(Word addr)
+{
+	// Code outside of PRG-ROM can be modified at any time, so it is never cached
+	if (addr < 0x8000)
+	{
+		decodeCacheMisses++;
+		Decode(addr, uncachedInstruction);
+		return uncachedInstruction;
+	}
+
+	uint32_t configuration = bus->GetPRGBankConfiguration();
+	DecodedInstruction& entry = decodeCache[addr - 0x8000];
+	if (entry.PRGBankConfiguration == configuration)
+	{
+		decodeCacheHits++;
+		return entry;
+	}
+
+	decodeCacheMisses++;
+	Decode(addr, entry);
+
+	// Instructions that wrap around into RAM can't be cached either
+	if ((uint32_t)addr + entry.Size <= 0x10000)
+		entry.PRGBankConfiguration = configuration;
+	else
+		entry.PRGBankConfiguration = 0;
+
+	return entry;
+}
+
+void CPU::Decode(Word addr, DecodedInstruction& target)
+{
+	target.Opcode = Read(addr);
+	target.Execute = HandlerTable[target.Opcode];
+	target.Cycles = InstructionTable[target.Opcode].Cycles;
+	target.Operand.Raw = 0x0000;
+
+	// Unknown opcodes still advance the PC past the opcode itself
+	target.Size = std::max<uint8_t>(InstructionTable[target.Opcode].Size, 1);
+	if (target.Size > 1)
+		target.Operand.Bytes.lo = Read((Word)(addr + 1));
+	if (target.Size > 2)
+		target.Operand.Bytes.hi = Read((Word)(addr + 2));
+}
+
+constexpr std::array<Instruction, 256> CPU::CreateInstructionTable()
+{
+	std::array<Instruction, 256> table{};
+
+	table[0x00] = NEW_INSTRUCTION(BRK, IMP, 1, 7);
+	table[0x01] = NEW_INSTRUCTION(ORA, IDX, 2, 6);
+	table[0x03] = NEW_ILLGL_INSTR(SLO, IDX, 2, 8);
+	table[0x04] = NEW_ILLGL_INSTR(NOP, ZPG, 2, 3);
+	table[0x05] = NEW_INSTRUCTION(ORA, ZPG, 2, 3);
+	table[0x06] = NEW_INSTRUCTION(ASL, ZPG, 2, 5);
+	table[0x07] = NEW_ILLGL_INSTR(SLO, ZPG, 2, 5);
+	table[0x08] = NEW_INSTRUCTION(PHP, IMP, 1, 3);
+	table[0x09] = NEW_INSTRUCTION(ORA, IMM, 2, 2);
+	table[0x0A] = NEW_INSTRUCTION(ASL, ACC, 1, 2);
+	table[0x0B] = NEW_ILLGL_INSTR(ANC, IMM, 2, 2);
+	table[0x0D] = NEW_INSTRUCTION(ORA, ABS, 3, 4);
+	table[0x0C] = NEW_ILLGL_INSTR(NOP, ABS, 3, 4);
+	table[0x0E] = NEW_INSTRUCTION(ASL, ABS, 3, 6);
+	table[0x0F] = NEW_ILLGL_INSTR(SLO, ABS, 3, 6);
+
+	table[0x10] = NEW_INSTRUCTION(BPL, REL, 2, 2);
+	table[0x11] = NEW_INSTRUCTION(ORA, IDY, 2, 5);
+	table[0x13] = NEW_ILLGL_INSTR(SLO, IDY, 2, 8);
+	table[0x14] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
+	table[0x15] = NEW_INSTRUCTION(ORA, ZPX, 2, 4);
+	table[0x16] = NEW_INSTRUCTION(ASL, ZPX, 2, 6);
+	table[0x17] = NEW_ILLGL_INSTR(SLO, ZPX, 2, 6);
+	table[0x18] = NEW_INSTRUCTION(CLC, IMP, 1, 2);
+	table[0x19] = NEW_INSTRUCTION(ORA, ABY, 3, 4);
+	table[0x1A] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
+	table[0x1B] = NEW_ILLGL_INSTR(SLO, ABY, 3, 7);
+	table[0x1C] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
+	table[0x1D] = NEW_INSTRUCTION(ORA, ABX, 3, 4);
+	table[0x1E] = NEW_INSTRUCTION(ASL, ABX, 3, 7);
+	table[0x1F] = NEW_ILLGL_INSTR(SLO, ABX, 3, 7);
+
+
+	table[0x20] = NEW_INSTRUCTION(JSR, ABS, 3, 6);
+	table[0x21] = NEW_INSTRUCTION(AND, IDX, 2, 6);
+	table[0x23] = NEW_ILLGL_INSTR(RLA, IDX, 2, 8);
+	table[0x24] = NEW_INSTRUCTION(BIT, ZPG, 2, 3);
+	table[0x25] = NEW_INSTRUCTION(AND, ZPG, 2, 3);
+	table[0x26] = NEW_INSTRUCTION(ROL, ZPG, 2, 5);
+	table[0x27] = NEW_ILLGL_INSTR(RLA, ZPG, 2, 5);
+	table[0x28] = NEW_INSTRUCTION(PLP, IMP, 1, 4);
+	table[0x29] = NEW_INSTRUCTION(AND, IMM, 2, 2);
+	table[0x2A] = NEW_INSTRUCTION(ROL, ACC, 1, 2);
+	table[0x2B] = NEW_ILLGL_INSTR(ANC, IMM, 2, 2);
+	table[0x2C] = NEW_INSTRUCTION(BIT, ABS, 3, 4);
+	table[0x2D] = NEW_INSTRUCTION(AND, ABS, 3, 4);
+	table[0x2E] = NEW_INSTRUCTION(ROL, ABS, 3, 6);
+	table[0x2F] = NEW_ILLGL_INSTR(RLA, ABS, 3, 6);
+
+	table[0x30] = NEW_INSTRUCTION(BMI, REL, 2, 2);
+	table[0x31] = NEW_INSTRUCTION(AND, IDY, 2, 5);
+	table[0x33] = NEW_ILLGL_INSTR(RLA, IDY, 2, 8);
+	table[0x34] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
+	table[0x35] = NEW_INSTRUCTION(AND, ZPX, 2, 4);
+	table[0x36] = NEW_INSTRUCTION(ROL, ZPX, 2, 6);
+	table[0x37] = NEW_ILLGL_INSTR(RLA, ZPX, 2, 6);
+	table[0x38] = NEW_INSTRUCTION(SEC, IMP, 1, 2);
+	table[0x39] = NEW_INSTRUCTION(AND, ABY, 3, 4);
+	table[0x3A] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
+	table[0x3B] = NEW_ILLGL_INSTR(RLA, ABY, 3, 7);
+	table[0x3C] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
+	table[0x3D] = NEW_INSTRUCTION(AND, ABX, 3, 4);
+	table[0x3E] = NEW_INSTRUCTION(ROL, ABX, 3, 7);
+	table[0x3F] = NEW_ILLGL_INSTR(RLA, ABX, 3, 7);
+
+	table[0x40] = NEW_INSTRUCTION(RTI, IMP, 1, 6);
+	table[0x41] = NEW_INSTRUCTION(EOR, IDX, 2, 6);
+	table[0x43] = NEW_ILLGL_INSTR(SRE, IDX, 2, 8);
+	table[0x44] = NEW_ILLGL_INSTR(NOP, ZPG, 2, 3);
+	table[0x45] = NEW_INSTRUCTION(EOR, ZPG, 2, 3);
+	table[0x46] = NEW_INSTRUCTION(LSR, ZPG, 2, 5);
+	table[0x47] = NEW_ILLGL_INSTR(SRE, ZPG, 2, 5);
+	table[0x48] = NEW_INSTRUCTION(PHA, IMP, 1, 3);
+	table[0x49] = NEW_INSTRUCTION(EOR, IMM, 2, 2);
+	table[0x4A] = NEW_INSTRUCTION(LSR, ACC, 1, 2);
+	table[0x4B] = NEW_ILLGL_INSTR(ALR, IMM, 2, 2);
+	table[0x4C] = NEW_INSTRUCTION(JMP, ABS, 3, 3);
+	table[0x4D] = NEW_INSTRUCTION(EOR, ABS, 3, 4);
+	table[0x4E] = NEW_INSTRUCTION(LSR, ABS, 3, 6);
+	table[0x4F] = NEW_ILLGL_INSTR(SRE, ABS, 3, 6);
+
+	table[0x50] = NEW_INSTRUCTION(BVC, REL, 2, 2);
+	table[0x51] = NEW_INSTRUCTION(EOR, IDY, 2, 5);
+	table[0x53] = NEW_ILLGL_INSTR(SRE, IDY, 2, 8);
+	table[0x54] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
+	table[0x55] = NEW_INSTRUCTION(EOR, ZPX, 2, 4);
+	table[0x56] = NEW_INSTRUCTION(LSR, ZPX, 2, 6);
+	table[0x57] = NEW_ILLGL_INSTR(SRE, ZPX, 2, 6);
+	table[0x58] = NEW_INSTRUCTION(CLI, IMP, 1, 2);
+	table[0x59] = NEW_INSTRUCTION(EOR, ABY, 3, 4);
+	table[0x5A] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
+	table[0x5B] = NEW_ILLGL_INSTR(SRE, ABY, 3, 7);
+	table[0x5C] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
+	table[0x5D] = NEW_INSTRUCTION(EOR, ABX, 3, 4);
+	table[0x5E] = NEW_INSTRUCTION(LSR, ABX, 3, 7);
+	table[0x5F] = NEW_ILLGL_INSTR(SRE, ABX, 3, 7);
+
+	table[0x60] = NEW_INSTRUCTION(RTS, IMP, 1, 6);
+	table[0x61] = NEW_INSTRUCTION(ADC, IDX, 2, 6);
+	table[0x63] = NEW_ILLGL_INSTR(RRA, IDX, 2, 8);
+	table[0x64] = NEW_ILLGL_INSTR(NOP, ZPG, 2, 3);
+	table[0x65] = NEW_INSTRUCTION(ADC, ZPG, 2, 3);
+	table[0x66] = NEW_INSTRUCTION(ROR, ZPG, 2, 5);
+	table[0x67] = NEW_ILLGL_INSTR(RRA, ZPG, 2, 5);
+	table[0x68] = NEW_INSTRUCTION(PLA, IMP, 1, 4);
+	table[0x69] = NEW_INSTRUCTION(ADC, IMM, 2, 2);
+	table[0x6A] = NEW_INSTRUCTION(ROR, ACC, 1, 2);
+	table[0x6B] = NEW_ILLGL_INSTR(ARR, IMM, 2, 2);
+	table[0x6C] = NEW_INSTRUCTION(JMP, IND, 3, 5);
+	table[0x6D] = NEW_INSTRUCTION(ADC, ABS, 3, 4);
+	table[0x6E] = NEW_INSTRUCTION(ROR, ABS, 3, 6);
+	table[0x6F] = NEW_ILLGL_INSTR(RRA, ABS, 3, 6);
+
+	table[0x70] = NEW_INSTRUCTION(BVS, REL, 2, 2);
+	table[0x71] = NEW_INSTRUCTION(ADC, IDY, 2, 5);
+	table[0x73] = NEW_ILLGL_INSTR(RRA, IDY, 2, 8);
+	table[0x74] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
+	table[0x75] = NEW_INSTRUCTION(ADC, ZPX, 2, 4);
+	table[0x76] = NEW_INSTRUCTION(ROR, ZPX, 2, 6);
+	table[0x77] = NEW_ILLGL_INSTR(RRA, ZPX, 2, 6);
+	table[0x78] = NEW_INSTRUCTION(SEI, IMP, 1, 2);
+	table[0x79] = NEW_INSTRUCTION(ADC, ABY, 3, 4);
+	table[0x7A] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
+	table[0x7B] = NEW_ILLGL_INSTR(RRA, ABY, 3, 7);
+	table[0x7C] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
+	table[0x7D] = NEW_INSTRUCTION(ADC, ABX, 3, 4);
+	table[0x7E] = NEW_INSTRUCTION(ROR, ABX, 3, 7);
+	table[0x7F] = NEW_ILLGL_INSTR(RRA, ABX, 3, 7);
+
+	table[0x80] = NEW_ILLGL_INSTR(NOP, IMM, 2, 2);
+	table[0x81] = NEW_INSTRUCTION(STA, IDX, 2, 6);
+	table[0x83] = NEW_ILLGL_INSTR(SAX, IDX, 2, 6);
+	table[0x82] = NEW_ILLGL_INSTR(NOP, IMM, 2, 2);
+	table[0x85] = NEW_INSTRUCTION(STA, ZPG, 2, 3);
+	table[0x84] = NEW_INSTRUCTION(STY, ZPG, 2, 3);
+	table[0x86] = NEW_INSTRUCTION(STX, ZPG, 2, 3);
+	table[0x87] = NEW_ILLGL_INSTR(SAX, ZPG, 2, 3);
+	table[0x88] = NEW_INSTRUCTION(DEY, IMP, 1, 2);
+	table[0x89] = NEW_ILLGL_INSTR(NOP, IMM, 2, 2);
+	table[0x8A] = NEW_INSTRUCTION(TXA, IMP, 1, 2);
+	table[0x8B] = NEW_ILLGL_INSTR(ANE, IMM, 2, 2);
+	table[0x8C] = NEW_INSTRUCTION(STY, ABS, 3, 4);
+	table[0x8D] = NEW_INSTRUCTION(STA, ABS, 3, 4);
+	table[0x8E] = NEW_INSTRUCTION(STX, ABS, 3, 4);
+	table[0x8F] = NEW_ILLGL_INSTR(SAX, ABS, 3, 4);
+
+	table[0x90] = NEW_INSTRUCTION(BCC, REL, 2, 2);
+	table[0x91] = NEW_INSTRUCTION(STA, IDY, 2, 6);
+	table[0x94] = NEW_INSTRUCTION(STY, ZPX, 2, 4);
+	table[0x95] = NEW_INSTRUCTION(STA, ZPX, 2, 4);
+	table[0x96] = NEW_INSTRUCTION(STX, ZPY, 2, 4);
+	table[0x97] = NEW_ILLGL_INSTR(SAX, ZPY, 2, 4);
+	table[0x98] = NEW_INSTRUCTION(TYA, IMP, 1, 2);
+	table[0x99] = NEW_INSTRUCTION(STA, ABY, 3, 5);
+	table[0x9A] = NEW_INSTRUCTION(TXS, IMP, 1, 2);
+	table[0x9C] = NEW_ILLGL_INSTR(SHY, ABX, 3, 5);
+	table[0x9D] = NEW_INSTRUCTION(STA, ABX, 3, 5);
+	table[0x9E] = NEW_ILLGL_INSTR(SHX, ABY, 3, 5);
+
+	table[0xA0] = NEW_INSTRUCTION(LDY, IMM, 2, 2);
+	table[0xA1] = NEW_INSTRUCTION(LDA, IDX, 2, 6);
+	table[0xA2] = NEW_INSTRUCTION(LDX, IMM, 2, 2);
+	table[0xA3] = NEW_ILLGL_INSTR(LAX, IDX, 2, 6);
+	table[0xA4] = NEW_INSTRUCTION(LDY, ZPG, 2, 3);
+	table[0xA5] = NEW_INSTRUCTION(LDA, ZPG, 2, 3);
+	table[0xA6] = NEW_INSTRUCTION(LDX, ZPG, 2, 3);
+	table[0xA7] = NEW_ILLGL_INSTR(LAX, ZPG, 2, 3);
+	table[0xA8] = NEW_INSTRUCTION(TAY, IMP, 1, 2);
+	table[0xA9] = NEW_INSTRUCTION(LDA, IMM, 2, 2);
+	table[0xAA] = NEW_INSTRUCTION(TAX, IMP, 1, 2);
+	table[0xAB] = NEW_ILLGL_INSTR(LXA, IMM, 2, 2);
+	table[0xAC] = NEW_INSTRUCTION(LDY, ABS, 3, 4);
+	table[0xAD] = NEW_INSTRUCTION(LDA, ABS, 3, 4);
+	table[0xAE] = NEW_INSTRUCTION(LDX, ABS, 3, 4);
+	table[0xAF] = NEW_ILLGL_INSTR(LAX, ABS, 3, 4);
+
+	table[0xB0] = NEW_INSTRUCTION(BCS, REL, 2, 2);
+	table[0xB1] = NEW_INSTRUCTION(LDA, IDY, 2, 5);
+	table[0xB3] = NEW_ILLGL_INSTR(LAX, IDY, 2, 5);
+	table[0xB4] = NEW_INSTRUCTION(LDY, ZPX, 2, 4);
+	table[0xB5] = NEW_INSTRUCTION(LDA, ZPX, 2, 4);
+	table[0xB6] = NEW_INSTRUCTION(LDX, ZPY, 2, 4);
+	table[0xB7] = NEW_ILLGL_INSTR(LAX, ZPY, 2, 4);
+	table[0xB8] = NEW_INSTRUCTION(CLV, IMP, 1, 2);
+	table[0xB9] = NEW_INSTRUCTION(LDA, ABY, 3, 4);
+	table[0xBA] = NEW_INSTRUCTION(TSX, IMP, 1, 2);
+	table[0xBC] = NEW_INSTRUCTION(LDY, ABX, 3, 4);
+	table[0xBD] = NEW_INSTRUCTION(LDA, ABX, 3, 4);
+	table[0xBE] = NEW_INSTRUCTION(LDX, ABY, 3, 4);
+	table[0xBF] = NEW_ILLGL_INSTR(LAX, ABY, 3, 4);
+
+	table[0xC0] = NEW_INSTRUCTION(CPY, IMM, 2, 2);
+	table[0xC1] = NEW_INSTRUCTION(CMP, IDX, 2, 6);
+	table[0xC2] = NEW_ILLGL_INSTR(NOP, IMM, 2, 2);
+	table[0xC3] = NEW_ILLGL_INSTR(DCP, IDX, 2, 8);
+	table[0xC4] = NEW_INSTRUCTION(CPY, ZPG, 2, 3);
+	table[0xC5] = NEW_INSTRUCTION(CMP, ZPG, 2, 3);
+	table[0xC6] = NEW_INSTRUCTION(DEC, ZPG, 2, 5);
+	table[0xC7] = NEW_ILLGL_INSTR(DCP, ZPG, 2, 5);
+	table[0xC8] = NEW_INSTRUCTION(INY, IMP, 1, 2);
+	table[0xC9] = NEW_INSTRUCTION(CMP, IMM, 2, 2);
+	table[0xCA] = NEW_INSTRUCTION(DEX, IMP, 1, 2);
+	table[0xCB] = NEW_ILLGL_INSTR(SBX, IMM, 2, 2);
+	table[0xCC] = NEW_INSTRUCTION(CPY, ABS, 3, 4);
+	table[0xCD] = NEW_INSTRUCTION(CMP, ABS, 3, 4);
+	table[0xCE] = NEW_INSTRUCTION(DEC, ABS, 3, 6);
+	table[0xCF] = NEW_ILLGL_INSTR(DCP, ABS, 3, 6);
+
+	table[0xD0] = NEW_INSTRUCTION(BNE, REL, 2, 2);
+	table[0xD1] = NEW_INSTRUCTION(CMP, IDY, 2, 5);
+	table[0xD3] = NEW_ILLGL_INSTR(DCP, IDY, 2, 8);
+	table[0xD4] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
+	table[0xD5] = NEW_INSTRUCTION(CMP, ZPX, 2, 4);
+	table[0xD6] = NEW_INSTRUCTION(DEC, ZPX, 2, 6);
+	table[0xD7] = NEW_ILLGL_INSTR(DCP, ZPX, 2, 6);
+	table[0xD8] = NEW_INSTRUCTION(CLD, IMP, 1, 2);
+	table[0xD9] = NEW_INSTRUCTION(CMP, ABY, 3, 4);
+	table[0xDA] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
+	table[0xDB] = NEW_ILLGL_INSTR(DCP, ABY, 3, 7);
+	table[0xDC] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
+	table[0xDD] = NEW_INSTRUCTION(CMP, ABX, 3, 4);
+	table[0xDE] = NEW_INSTRUCTION(DEC, ABX, 3, 7);
+	table[0xDF] = NEW_ILLGL_INSTR(DCP, ABX, 3, 7);
+
+	table[0xE0] = NEW_INSTRUCTION(CPX, IMM, 2, 2);
+	table[0xE1] = NEW_INSTRUCTION(SBC, IDX, 2, 6);
+	table[0xE2] = NEW_ILLGL_INSTR(NOP, IMM, 2, 2);
+	table[0xE3] = NEW_ILLGL_INSTR(ISC, IDX, 2, 8);
+	table[0xE4] = NEW_INSTRUCTION(CPX, ZPG, 2, 3);
+	table[0xE5] = NEW_INSTRUCTION(SBC, ZPG, 2, 3);
+	table[0xE6] = NEW_INSTRUCTION(INC, ZPG, 2, 5);
+	table[0xE7] = NEW_ILLGL_INSTR(ISC, ZPG, 2, 5);
+	table[0xE8] = NEW_INSTRUCTION(INX, IMP, 1, 2);
+	table[0xE9] = NEW_INSTRUCTION(SBC, IMM, 2, 2);
+	table[0xEA] = NEW_INSTRUCTION(NOP, IMP, 1, 2);
+	table[0xEB] = NEW_ILLGL_INSTR(SBC, IMM, 2, 2);
+	table[0xEC] = NEW_INSTRUCTION(CPX, ABS, 3, 4);
+	table[0xED] = NEW_INSTRUCTION(SBC, ABS, 3, 4);
+	table[0xEE] = NEW_INSTRUCTION(INC, ABS, 3, 6);
+	table[0xEF] = NEW_ILLGL_INSTR(ISC, ABS, 3, 6);
+
+	table[0xF0] = NEW_INSTRUCTION(BEQ, REL, 2, 2);
+	table[0xF1] = NEW_INSTRUCTION(SBC, IDY, 2, 5);
+	table[0xF3] = NEW_ILLGL_INSTR(ISC, IDY, 2, 8);
+	table[0xF4] = NEW_ILLGL_INSTR(NOP, ZPX, 2, 4);
+	table[0xF5] = NEW_INSTRUCTION(SBC, ZPX, 2, 4);
+	table[0xF6] = NEW_INSTRUCTION(INC, ZPX, 2, 6);
+	table[0xF7] = NEW_ILLGL_INSTR(ISC, ZPX, 2, 6);
+	table[0xF8] = NEW_INSTRUCTION(SED, IMP, 1, 2);
+	table[0xF9] = NEW_INSTRUCTION(SBC, ABY, 3, 4);
+	table[0xFA] = NEW_ILLGL_INSTR(NOP, IMP, 1, 2);
+	table[0xFB] = NEW_ILLGL_INSTR(ISC, ABY, 3, 7);
+	table[0xFC] = NEW_ILLGL_INSTR(NOP, ABX, 3, 4);
+	table[0xFD] = NEW_INSTRUCTION(SBC, ABX, 3, 4);
+	table[0xFE] = NEW_INSTRUCTION(INC, ABX, 3, 7);
+	table[0xFF] = NEW_ILLGL_INSTR(ISC, ABX, 3, 7);
+
+	return table;
+}
+
+constexpr std::array<Instruction, 256> CPU::InstructionTable = CPU::CreateInstructionTable();
+
+template<std::size_t... Opcodes>
+constexpr std::array<Handler, 256> CPU::CreateHandlerTable(std::index_sequence<Opcodes...>)
+{
+	// Opcodes that aren't in the instruction table have no cycles and get no handler
+	return { (InstructionTable[Opcodes].Cycles != 0 ? &CPU::Execute<Opcodes> : nullptr)... };
+}
+
+constexpr std::array<Handler, 256> CPU::HandlerTable = CPU::CreateHandlerTable(std::make_index_sequence<256>{});
+
+template<Byte Opcode>
+void CPU::Execute(CPU& cpu)
+{
+	constexpr Instruction instruction = InstructionTable[Opcode];
+
+	cpu.ResolveAddress<instruction.AddrType>();
+	(cpu.*instruction.Opcode)();
+}
+
+template<Addressing Mode>
+void CPU::ResolveAddress()
+{
+	if constexpr (Mode == Addressing::ABS) ABS();
+	else if constexpr (Mode == Addressing::ABX) ABX();
+	else if constexpr (Mode == Addressing::ABY) ABY();
+	else if constexpr (Mode == Addressing::ACC) ACC();
+	else if constexpr (Mode == Addressing::IDX) IDX();
+	else if constexpr (Mode == Addressing::IDY) IDY();
+	else if constexpr (Mode == Addressing::IMM) IMM();
+	else if constexpr (Mode == Addressing::IMP) IMP();
+	else if constexpr (Mode == Addressing::IND) IND();
+	else if constexpr (Mode == Addressing::REL) REL();
+	else if constexpr (Mode == Addressing::ZPG) ZPG();
+	else if constexpr (Mode == Addressing::ZPX) ZPX();
+	else if constexpr (Mode == Addressing::ZPY) ZPY();
 }
 
 void CPU::Powerup()
 {
-	status.Raw = 0x24;
+	SetStatus(0x24);
 	acc = 0;
 	idx = 0;
 	idy = 0;
@@ -362,6 +463,40 @@ void CPU::Reset()
 	halted = false;
 }
 
+void CPU::Serialize(SaveState& state) const
+{
+	state.Write(acc);
+	state.Write(idx);
+	state.Write(idy);
+	state.Write(pc);
+	state.Write(sp);
+	state.Write(status);
+	state.Write(negativeResult);
+	state.Write(zeroResult);
+	state.Write(carry);
+	state.Write(remainingCycles);
+	state.Write(totalCycles);
+	state.Write(executedInstructions);
+	state.Write(halted);
+}
+
+void CPU::Deserialize(SaveState& state)
+{
+	state.Read(acc);
+	state.Read(idx);
+	state.Read(idy);
+	state.Read(pc);
+	state.Read(sp);
+	state.Read(status);
+	state.Read(negativeResult);
+	state.Read(zeroResult);
+	state.Read(carry);
+	state.Read(remainingCycles);
+	state.Read(totalCycles);
+	state.Read(executedInstructions);
+	state.Read(halted);
+}
+
 void CPU::IRQ()
 {
 	if (status.Flag.InterruptDisable)
@@ -369,7 +504,7 @@ void CPU::IRQ()
 
 	Push(pc.Bytes.hi);
 	Push(pc.Bytes.lo);
-	Push(status.Raw | (0x1 << 5));
+	Push(GetStatus().Raw | (0x1 << 5));
 
 	status.Flag.InterruptDisable = 1;
 	pc.Bytes.lo = Read(0xFFFE);
@@ -380,7 +515,7 @@ void CPU::NMI()
 {
 	Push(pc.Bytes.hi);
 	Push(pc.Bytes.lo);
-	Push(status.Raw | (0x1 << 5));
+	Push(GetStatus().Raw | (0x1 << 5));
 
 	status.Flag.InterruptDisable = 1;
 	pc.Bytes.lo = Read(0xFFFA);
@@ -391,14 +526,12 @@ void CPU::NMI()
 
 void CPU::ABS()
 {
-	absoluteAddress.Bytes.lo = Read(pc.Raw++);
-	absoluteAddress.Bytes.hi = Read(pc.Raw++);
+	absoluteAddress.Raw = operand.Raw;
 }
 
 void CPU::ABX()
 {
-	rawAddress.Bytes.lo = Read(pc.Raw++);
-	rawAddress.Bytes.hi = Read(pc.Raw++);
+	rawAddress.Raw = operand.Raw;
 
 	absoluteAddress.Raw = rawAddress.Raw + idx;
 
@@ -408,8 +541,7 @@ void CPU::ABX()
 
 void CPU::ABY()
 {
-	rawAddress.Bytes.lo = Read(pc.Raw++);
-	rawAddress.Bytes.hi = Read(pc.Raw++);
+	rawAddress.Raw = operand.Raw;
 
 	absoluteAddress.Raw = rawAddress.Raw + idy;
 
@@ -421,11 +553,12 @@ void CPU::ACC()
 {
 	fetchedVal = acc;
 	accumulatorAddressing = true;
+	valueFetched = true;
 }
 
 void CPU::IDX()
 {
-	Byte index = Read(pc.Raw++);
+	Byte index = operand.Bytes.lo;
 	Byte indirectAddress = index + idx;
 
 	absoluteAddress.Bytes.lo = Read(indirectAddress);
@@ -434,7 +567,7 @@ void CPU::IDX()
 
 void CPU::IDY()
 {
-	Byte index = Read(pc.Raw++);
+	Byte index = operand.Bytes.lo;
 	rawAddress.Bytes.lo = Read(index);
 	rawAddress.Bytes.hi = Read((index + 1) & 0xFF);
 
@@ -446,7 +579,8 @@ void CPU::IDY()
 
 void CPU::IMM()
 {
-	absoluteAddress.Raw = pc.Raw++;
+	fetchedVal = operand.Bytes.lo;
+	valueFetched = true;
 }
 
 void CPU::IMP()
@@ -456,8 +590,7 @@ void CPU::IMP()
 
 void CPU::IND()
 {
-	rawAddress.Bytes.lo = Read(pc.Raw++);
-	rawAddress.Bytes.hi = Read(pc.Raw++);
+	rawAddress.Raw = operand.Raw;
 
 	absoluteAddress.Bytes.lo = Read(rawAddress.Raw);
 	rawAddress.Bytes.lo++;
@@ -466,18 +599,18 @@ void CPU::IND()
 
 void CPU::REL()
 {
-	relativeAddress = Read(pc.Raw++);
+	relativeAddress = operand.Bytes.lo;
 }
 
 void CPU::ZPG()
 {
 	absoluteAddress.Bytes.hi = 0x00;
-	absoluteAddress.Bytes.lo = Read(pc.Raw++);
+	absoluteAddress.Bytes.lo = operand.Bytes.lo;
 }
 
 void CPU::ZPX()
 {
-	rawAddress.Bytes.lo = Read(pc.Raw++);
+	rawAddress.Bytes.lo = operand.Bytes.lo;
 
 	absoluteAddress.Bytes.hi = 0x00;
 	absoluteAddress.Bytes.lo = rawAddress.Bytes.lo + idx;
@@ -485,7 +618,7 @@ void CPU::ZPX()
 
 void CPU::ZPY()
 {
-	rawAddress.Bytes.lo = Read(pc.Raw++);
+	rawAddress.Bytes.lo = operand.Bytes.lo;
 
 	absoluteAddress.Bytes.hi = 0x00;
 	absoluteAddress.Bytes.lo = rawAddress.Bytes.lo + idy;
@@ -498,14 +631,14 @@ void CPU::ZPY()
 void CPU::ADC()
 {
 	FetchValue();
-	Word result = (Word)acc + fetchedVal + status.Flag.Carry;
+	Word result = (Word)acc + fetchedVal + carry;
 
 	status.Flag.Overflow = ((((~acc & ~fetchedVal & result) | (acc & fetchedVal & ~result)) & 0x80) == 0x80);
 
 	acc = result & 0xFF;
 	CHECK_NEGATIVE(acc);
 	CHECK_ZERO(acc);
-	status.Flag.Carry = ((result & 0x100) == 0x100);
+	carry = ((result & 0x100) == 0x100);
 }
 
 void CPU::ALR()
@@ -513,10 +646,10 @@ void CPU::ALR()
 	FetchValue();
 	acc &= fetchedVal;
 
-	status.Flag.Carry = ((acc & 0x01) == 0x01);
+	carry = ((acc & 0x01) == 0x01);
 	acc >>= 1;
 
-	status.Flag.Negative = 0;
+	negativeResult = 0;
 	CHECK_ZERO(acc);
 
 	additionalCycles = 0;
@@ -529,7 +662,7 @@ void CPU::ANC()
 
 	CHECK_NEGATIVE(acc);
 	CHECK_ZERO(acc);
-	status.Flag.Carry = ((acc & 0x80) == 0x80);
+	carry = ((acc & 0x80) == 0x80);
 }
 
 void CPU::AND()
@@ -560,18 +693,18 @@ void CPU::ARR()
 	acc &= fetchedVal;
 
 	acc >>= 1;
-	acc |= (status.Flag.Carry << 7);
+	acc |= (carry << 7);
 
 	CHECK_NEGATIVE(acc);
 	CHECK_ZERO(acc);
 	status.Flag.Overflow = ((acc >> 6) & 0x1) ^ ((acc >> 5) & 0x1);
-	status.Flag.Carry = ((acc >> 6) & 0x1);
+	carry = ((acc >> 6) & 0x1);
 }
 
 void CPU::ASL()
 {
 	FetchValue();
-	status.Flag.Carry = ((fetchedVal & 0x80) == 0x80);
+	carry = ((fetchedVal & 0x80) == 0x80);
 	fetchedVal <<= 1;
 
 	CHECK_NEGATIVE(fetchedVal);
@@ -585,7 +718,7 @@ void CPU::ASL()
 
 void CPU::BCC()
 {
-	if (!status.Flag.Carry)
+	if (!carry)
 	{
 		absoluteAddress.Raw = pc.Raw + (int8_t)relativeAddress;
 
@@ -599,7 +732,7 @@ void CPU::BCC()
 
 void CPU::BCS()
 {
-	if (status.Flag.Carry)
+	if (carry)
 	{
 		absoluteAddress.Raw = pc.Raw + (int8_t)relativeAddress;
 
@@ -613,7 +746,7 @@ void CPU::BCS()
 
 void CPU::BEQ()
 {
-	if (status.Flag.Zero)
+	if (zeroResult == 0)
 	{
 		absoluteAddress.Raw = pc.Raw + (int8_t)relativeAddress;
 
@@ -628,7 +761,7 @@ void CPU::BEQ()
 void CPU::BIT()
 {
 	FetchValue();
-	status.Flag.Negative = ((fetchedVal & 0x80) == 0x80);
+	negativeResult = fetchedVal;
 	status.Flag.Overflow = ((fetchedVal & 0x40) == 0x40);
 
 	CHECK_ZERO(acc & fetchedVal);
@@ -636,7 +769,7 @@ void CPU::BIT()
 
 void CPU::BMI()
 {
-	if (status.Flag.Negative)
+	if (negativeResult & 0x80)
 	{
 		absoluteAddress.Raw = pc.Raw + (int8_t)relativeAddress;
 
@@ -650,7 +783,7 @@ void CPU::BMI()
 
 void CPU::BNE()
 {
-	if (!status.Flag.Zero)
+	if (zeroResult != 0)
 	{
 		absoluteAddress.Raw = pc.Raw + (int8_t)relativeAddress;
 
@@ -664,7 +797,7 @@ void CPU::BNE()
 
 void CPU::BPL()
 {
-	if (!status.Flag.Negative)
+	if (!(negativeResult & 0x80))
 	{
 		absoluteAddress.Raw = pc.Raw + (int8_t)relativeAddress;
 
@@ -681,7 +814,7 @@ void CPU::BRK()
 	pc.Raw++;
 	Push(pc.Bytes.hi);
 	Push(pc.Bytes.lo);
-	Push(status.Raw | (0x3 << 4));
+	Push(GetStatus().Raw | (0x3 << 4));
 
 	status.Flag.InterruptDisable = 1;
 	pc.Bytes.lo = Read(0xFFFE);
@@ -719,7 +852,7 @@ void CPU::BVS()
 
 void CPU::CLC()
 {
-	status.Flag.Carry = 0;
+	carry = 0;
 }
 
 void CPU::CLD()
@@ -744,7 +877,7 @@ void CPU::CMP()
 
 	CHECK_NEGATIVE(result);
 	CHECK_ZERO(result);
-	status.Flag.Carry = (acc >= fetchedVal);
+	carry = (acc >= fetchedVal);
 }
 
 void CPU::CPX()
@@ -754,7 +887,7 @@ void CPU::CPX()
 
 	CHECK_NEGATIVE(result);
 	CHECK_ZERO(result);
-	status.Flag.Carry = (idx >= fetchedVal);
+	carry = (idx >= fetchedVal);
 }
 
 void CPU::CPY()
@@ -764,7 +897,7 @@ void CPU::CPY()
 
 	CHECK_NEGATIVE(result);
 	CHECK_ZERO(result);
-	status.Flag.Carry = (idy >= fetchedVal);
+	carry = (idy >= fetchedVal);
 }
 
 void CPU::DCP()
@@ -777,7 +910,7 @@ void CPU::DCP()
 
 	CHECK_NEGATIVE(result);
 	CHECK_ZERO(result);
-	status.Flag.Carry = (acc >= fetchedVal);
+	carry = (acc >= fetchedVal);
 
 	additionalCycles = 0;
 }
@@ -845,14 +978,14 @@ void CPU::ISC()
 	fetchedVal++;
 	Write(absoluteAddress.Raw, fetchedVal);
 
-	Word result = (Word)acc - fetchedVal - (1 - status.Flag.Carry);
+	Word result = (Word)acc - fetchedVal - (1 - carry);
 
 	status.Flag.Overflow = ((((~acc & fetchedVal & result) | (acc & ~fetchedVal & ~result)) & 0x80) == 0x80);
 
 	acc = result & 0xFF;
 	CHECK_NEGATIVE(acc);
 	CHECK_ZERO(acc);
-	status.Flag.Carry = ((result & 0x100) != 0x100);
+	carry = ((result & 0x100) != 0x100);
 
 	additionalCycles = 0;
 }
@@ -910,10 +1043,10 @@ void CPU::LDY()
 void CPU::LSR()
 {
 	FetchValue();
-	status.Flag.Carry = ((fetchedVal & 0x01) == 0x01);
+	carry = ((fetchedVal & 0x01) == 0x01);
 	fetchedVal >>= 1;
 
-	status.Flag.Negative = 0;
+	negativeResult = 0;
 	CHECK_ZERO(fetchedVal);
 
 	if (accumulatorAddressing)
@@ -955,7 +1088,7 @@ void CPU::PHA()
 
 void CPU::PHP()
 {
-	Push(status.Raw | (0x3 << 4));
+	Push(GetStatus().Raw | (0x3 << 4));
 }
 
 void CPU::PLA()
@@ -968,17 +1101,17 @@ void CPU::PLA()
 
 void CPU::PLP()
 {
-	static Byte mask = 0x3 << 4;
+	constexpr Byte mask = 0x3 << 4;
 
-	status.Raw = (status.Raw & mask) | (Pop() & ~mask);
+	SetStatus((status.Raw & mask) | (Pop() & ~mask));
 }
 
 void CPU::RLA()
 {
 	FetchValue();
 
-	Byte oldCarry = status.Flag.Carry;
-	status.Flag.Carry = ((fetchedVal & 0x80) == 0x80);
+	Byte oldCarry = carry;
+	carry = ((fetchedVal & 0x80) == 0x80);
 	fetchedVal <<= 1;
 	fetchedVal |= oldCarry;
 
@@ -996,8 +1129,8 @@ void CPU::ROL()
 {
 	FetchValue();
 
-	Byte oldCarry = status.Flag.Carry;
-	status.Flag.Carry = ((fetchedVal & 0x80) == 0x80);
+	Byte oldCarry = carry;
+	carry = ((fetchedVal & 0x80) == 0x80);
 	fetchedVal <<= 1;
 	fetchedVal |= oldCarry;
 
@@ -1014,8 +1147,8 @@ void CPU::ROR()
 {
 	FetchValue();
 
-	Byte oldCarry = status.Flag.Carry;
-	status.Flag.Carry = ((fetchedVal & 0x01) == 0x01);
+	Byte oldCarry = carry;
+	carry = ((fetchedVal & 0x01) == 0x01);
 	fetchedVal >>= 1;
 	fetchedVal |= (oldCarry << 7);
 
@@ -1032,30 +1165,30 @@ void CPU::RRA()
 {
 	FetchValue();
 
-	Byte oldCarry = status.Flag.Carry;
-	status.Flag.Carry = ((fetchedVal & 0x01) == 0x01);
+	Byte oldCarry = carry;
+	carry = ((fetchedVal & 0x01) == 0x01);
 	fetchedVal >>= 1;
 	fetchedVal |= (oldCarry << 7);
 	
 	Write(absoluteAddress.Raw, fetchedVal);
 
-	Word result = (Word)acc + fetchedVal + status.Flag.Carry;
+	Word result = (Word)acc + fetchedVal + carry;
 
 	status.Flag.Overflow = ((((~acc & ~fetchedVal & result) | (acc & fetchedVal & ~result)) & 0x80) == 0x80);
 
 	acc = result & 0xFF;
 	CHECK_NEGATIVE(acc);
 	CHECK_ZERO(acc);
-	status.Flag.Carry = ((result & 0x100) == 0x100);
+	carry = ((result & 0x100) == 0x100);
 
 	additionalCycles = 0;
 }
 
 void CPU::RTI()
 {
-	static Byte mask = 0x3 << 4;
+	constexpr Byte mask = 0x3 << 4;
 
-	status.Raw = (status.Raw & mask) | (Pop() & ~mask);
+	SetStatus((status.Raw & mask) | (Pop() & ~mask));
 	pc.Bytes.lo = Pop();
 	pc.Bytes.hi = Pop();
 }
@@ -1079,7 +1212,7 @@ void CPU::SBX()
 
 	CHECK_NEGATIVE(result);
 	CHECK_ZERO(result);
-	status.Flag.Carry = ((acc & idx) >= fetchedVal);
+	carry = ((acc & idx) >= fetchedVal);
 
 	idx = (Byte)(result & 0xFF);
 }
@@ -1087,19 +1220,19 @@ void CPU::SBX()
 void CPU::SBC()
 {
 	FetchValue();
-	Word result = (Word)acc - fetchedVal - (1 - status.Flag.Carry);
+	Word result = (Word)acc - fetchedVal - (1 - carry);
 
 	status.Flag.Overflow = ((((~acc & fetchedVal & result) | (acc & ~fetchedVal & ~result)) & 0x80) == 0x80);
 
 	acc = result & 0xFF;
 	CHECK_NEGATIVE(acc);
 	CHECK_ZERO(acc);
-	status.Flag.Carry = ((result & 0x100) != 0x100);
+	carry = ((result & 0x100) != 0x100);
 }
 
 void CPU::SEC()
 {
-	status.Flag.Carry = 1;
+	carry = 1;
 }
 
 void CPU::SED()
@@ -1133,7 +1266,7 @@ void CPU::SHY()
 void CPU::SLO()
 {
 	FetchValue();
-	status.Flag.Carry = ((fetchedVal & 0x80) == 0x80);
+	carry = ((fetchedVal & 0x80) == 0x80);
 	fetchedVal <<= 1;
 
 	Write(absoluteAddress.Raw, fetchedVal);
@@ -1149,7 +1282,7 @@ void CPU::SLO()
 void CPU::SRE()
 {
 	FetchValue();
-	status.Flag.Carry = ((fetchedVal & 0x01) == 0x01);
+	carry = ((fetchedVal & 0x01) == 0x01);
 	fetchedVal >>= 1;
 
 	Write(absoluteAddress.Raw, fetchedVal);
@@ -1,15 +1,18 @@
 #pragma once
 
 #include <array>
-#include <functional>
+#include <utility>
 #include <sstream>
 #include <deque>
+#include <vector>
 #include "Types.hpp"
 
 class Bus;
+class CPU;
+class SaveState;
 
-using Operation = std::function<void(void)>;
-using AddressingMode = std::function<void(void)>;
+using Operation = void (CPU::*)();
+using Handler = void (*)(CPU&);
 
 /**
  * @brief Addressing modes of the CPU.
@@ -50,17 +53,33 @@ union StatusFlag
 
 /**
  * @brief Stores data of an instruction.
+ * This is only needed to generate the handler table and by the debugger,
+ * the CPU itself dispatches through CPU::HandlerTable
  */
 struct Instruction
 {
 	Operation Opcode = nullptr;
-	AddressingMode Mode = nullptr;		
 	Addressing AddrType = Addressing::IMP;	
 	uint8_t Size = 0;
 	uint8_t Cycles = 0;
 	char Mnemonic[5] = " ???";
 };
 
+/**
+ * @brief An instruction that has already been fetched and decoded.
+ * Instructions in PRG-ROM are cached in this form, so that they don't
+ * have to go through the bus and the mapper every time they are executed
+ */
+struct DecodedInstruction
+{
+	Handler Execute = nullptr;
+	Address Operand = { 0x0000 };		//< Pre-fetched operand bytes
+	Byte Opcode = 0x00;
+	uint8_t Size = 0;
+	uint8_t Cycles = 0;
+	uint32_t PRGBankConfiguration = 0;	//< Mapper configuration this was decoded under, 0 = invalid
+};
+
 /**
  * @brief Represents the CPU.
  */
@@ -75,9 +94,16 @@ public:
 	CPU(Bus* bus);
 
 	/**
-	 * @brief Do one CPU cycle.
+	 * @brief Execute the next instruction.
+	 * Returns the number of cycles it takes, the CPU is busy for the remaining
+	 * cycles after the first one. Returns 0 if the CPU is halted
 	 */
-	uint8_t Tick();
+	uint8_t Step();
+
+	/**
+	 * @brief Cycles the CPU is still busy with after the cycle it executed its last instruction in.
+	 */
+	inline uint8_t GetRemainingCycles() const { return remainingCycles; }
 
 	/**
 	 * @brief Powerup the CPU.
@@ -95,6 +121,18 @@ public:
 	 * @brief Halt the CPU (stops it from executing anything).
 	 */
 	inline void Halt() { halted = true; }
+	inline bool IsHalted() const { return halted; }
+
+	/**
+	 * @brief Save the registers and the cycle counters.
+	 */
+	void Serialize(SaveState& state) const;
+
+	/**
+	 * @brief Restore the registers and the cycle counters.
+	 * Decoded instructions and cached blocks stay valid, they are tied to the PRG bank configuration
+	 */
+	void Deserialize(SaveState& state);
 
 	/**
 	 * @brief Request an interrupt.
@@ -109,11 +147,64 @@ public:
 
 	uint64_t GetTotalCycles() { return totalCycles; }
 
+	/**
+	 * @brief Number of instructions executed since powerup.
+	 */
+	inline uint64_t GetExecutedInstructions() const { return executedInstructions; }
+
+	/**
+	 * @brief Assemble the status register.
+	 * The negative, zero and carry flags are only evaluated when the status register is observed
+	 */
+	inline StatusFlag GetStatus() const
+	{
+		StatusFlag result = status;
+		result.Flag.Negative = (negativeResult >> 7);
+		result.Flag.Zero = (zeroResult == 0x00);
+		result.Flag.Carry = carry;
+		return result;
+	}
+
+	/**
+	 * @brief Overwrite the status register.
+	 */
+	void SetStatus(Byte raw);
+
+	/**
+	 * @brief Number of instructions served from the decode cache.
+	 */
+	inline uint64_t GetDecodeCacheHits() const { return decodeCacheHits; }
+
+	/**
+	 * @brief Number of instructions that had to be decoded from memory.
+	 * This includes all instructions executed from RAM, as they are never cached
+	 */
+	inline uint64_t GetDecodeCacheMisses() const { return decodeCacheMisses; }
+
 private:
 	/**
 	 * @brief Create a lookup table of instructions.
 	 */
-	void CreateInstructionTable();
+	static constexpr std::array<Instruction, 256> CreateInstructionTable();
+
+	/**
+	 * @brief Create the table of opcode handlers from the instruction table.
+	 */
+	template<std::size_t... Opcodes>
+	static constexpr std::array<Handler, 256> CreateHandlerTable(std::index_sequence<Opcodes...>);
+
+	/**
+	 * @brief Handler for a single opcode.
+	 * Addressing mode and operation are resolved at compile time
+	 */
+	template<Byte Opcode>
+	static void Execute(CPU& cpu);
+
+	/**
+	 * @brief Invoke the given addressing mode.
+	 */
+	template<Addressing Mode>
+	void ResolveAddress();
 
 	/**
 	 * @brief Push a byte to the stack
@@ -145,16 +236,35 @@ private:
 	void Write(Word addr, Byte val);
 
 	void FetchValue();
+
+	/**
+	 * @brief Get the decoded instruction at the given address.
+	 * Instructions in PRG-ROM are taken from the decode cache if possible
+	 */
+	const DecodedInstruction& Fetch(Word addr);
+
+	/**
+	 * @brief Fetch and decode the instruction at the given address from memory.
+	 */
+	void Decode(Word addr, DecodedInstruction& target);
+
+	/**
+	 * @brief Execute a decoded instruction located at the PC.
+	 * Returns the number of cycles it took
+	 */
+	uint8_t Execute(const DecodedInstruction& instruction);
 	
 private:	// Stuff regarding addressing modes
 	Address rawAddress;			//< Temporary storage while decoding addresses
 	Address absoluteAddress;	//< Address the current instruction operates on
 	Byte relativeAddress;		//< (Relative) address the current instruction operates on
+	Address operand;			//< Operand bytes of the current instruction
 	Byte fetchedVal;			//< The value needed for the current instruction
 	bool accumulatorAddressing = false;
+	bool valueFetched = false;	//< Set by addressing modes that don't need to read memory
 
 	// The following functions all perform the same steps:
-	//  1. Fetch bytes needed for opcode (if any) and advance PC
+	//  1. Take the bytes needed for the opcode (if any) from the pre-fetched operand
 	//  2. Construct the address the instruction operates on (addressing mode specific)
 	//  3. Fetch the value in RAM at that address
 	void ABS();		// Absolute
@@ -253,20 +363,31 @@ private:	// CPU internals
 	Byte idx, idy;
 	Address pc;
 	Byte sp;
-	StatusFlag status;
+	StatusFlag status;			//< Negative, zero and carry flag are out of date, use GetStatus()
+	Byte negativeResult = 0;	//< Last result that affected the negative flag (bit 7)
+	Byte zeroResult = 1;		//< Last result that affected the zero flag (0 = set)
+	Byte carry = 0;
 
-	Instruction* currentInstruction = nullptr;
+	const Instruction* currentInstruction = nullptr;
 	uint8_t remainingCycles = 0;
 	uint8_t additionalCycles = 0;	//< E.g. when a page boundary was crossed
 	uint64_t totalCycles = 0;
-	std::deque<std::pair<Word, Instruction*>> pastInstructions;	//< For debugging, saves the past 50 instructions
+	uint64_t executedInstructions = 0;
+	std::deque<std::pair<Word, const Instruction*>> pastInstructions;	//< For debugging, saves the past 50 instructions
 	bool halted = false;
 
+	// Decoded instructions for $8000-$FFFF
+	std::vector<DecodedInstruction> decodeCache;
+	DecodedInstruction uncachedInstruction;	//< Storage for instructions outside of PRG-ROM
+	uint64_t decodeCacheHits = 0;
+	uint64_t decodeCacheMisses = 0;
+
 #ifndef NDEBUG
 	std::stringstream debugString;
 #endif
 
 private:
-	std::array<Instruction, 256> InstructionTable;
+	static const std::array<Instruction, 256> InstructionTable;	//< Cold instruction data (mnemonics, sizes, ...)
+	static const std::array<Handler, 256> HandlerTable;			//< Hot opcode dispatch table
 	Bus* bus;
 };
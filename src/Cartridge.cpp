@@ -10,7 +10,12 @@
 #include "mappers/Mapper003.hpp"
 
 Cartridge::Cartridge(Bus* bus) :
-	bus(bus), mapper(nullptr)
+	mapper(nullptr), bus(bus)
+{
+}
+
+Cartridge::Cartridge(Bus* bus, const Cartridge& other) :
+	mapper(other.mapper->Clone()), romHash(other.romHash), bus(bus)
 {
 }
 
@@ -43,4 +48,27 @@ void Cartridge::Load(std::string path)
 	default:
 		throw std::runtime_error("Unsupported mapper ID " + std::to_string(mapperNumber));
 	}
+
+	// Identifies the ROM in save states (FNV-1a)
+	file.clear();
+	file.seekg(sizeof(Header));
+	romHash = 0xCBF29CE484222325;
+	for (char c; file.get(c);)
+		romHash = (romHash ^ (Byte)c) * 0x100000001B3;
+}
+
+void Cartridge::Serialize(SaveState& state) const
+{
+	state.Write(romHash);
+	mapper->Serialize(state);
+}
+
+void Cartridge::Deserialize(SaveState& state)
+{
+	uint64_t savedHash;
+	state.Read(savedHash);
+	if (savedHash != romHash)
+		throw std::runtime_error("Save state belongs to a different ROM");
+
+	mapper->Deserialize(state);
 }
@@ -18,6 +18,14 @@ public:
 	 * @brief Add a cartridge to the Bus.
 	 */
 	Cartridge(Bus* bus);
+
+	/**
+	 * @brief Add a copy of another cartridge to the Bus.
+	 * Both share the ROM, the mapper's registers and writable memory are copied
+	 */
+	Cartridge(Bus* bus, const Cartridge& other);
+	Cartridge(const Cartridge&) = delete;
+	Cartridge& operator=(const Cartridge&) = delete;
 	~Cartridge();
 
 	/**
@@ -30,6 +38,11 @@ public:
 	 */
 	inline Byte ReadPPU(Word addr) { return mapper->ReadPPU(addr); }
 
+	/**
+	 * @brief Read a decoded tile row from the PPU.
+	 */
+	inline const TileCache::Row& ReadTileRow(Word addr) { return mapper->ReadTileRow(addr); }
+
 	/**
 	 * @brief Wrote from the CPU.
 	 */
@@ -55,7 +68,19 @@ public:
 	 */
 	inline Mapper* GetMapper() { return mapper; }
 
+	/**
+	 * @brief Save the mapper state, tagged with the ROM it belongs to.
+	 */
+	void Serialize(SaveState& state) const;
+
+	/**
+	 * @brief Restore the mapper state.
+	 * Throws before changing anything if the state was saved with a different ROM
+	 */
+	void Deserialize(SaveState& state);
+
 private:
 	Mapper* mapper;
+	uint64_t romHash = 0;	//< Hash of the ROM file's contents (after the header)
 	Bus* bus;
 };
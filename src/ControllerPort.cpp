@@ -9,6 +9,13 @@ ControllerPort::ControllerPort() :
 	}
 }
 
+ControllerPort::ControllerPort(const ControllerPort& other) :
+	latch(other.latch), input(other.input)
+{
+	for (size_t port = 0; port < connectedDevices.size(); port++)
+		connectedDevices[port] = other.connectedDevices[port] ? other.connectedDevices[port]->Clone() : nullptr;
+}
+
 ControllerPort::~ControllerPort()
 {
 	for (Controller* controller : connectedDevices)
@@ -20,7 +27,18 @@ ControllerPort::~ControllerPort()
 
 void ControllerPort::Write(Byte val)
 {
+	// The controllers keep reloading while the strobe bit is set, and hold
+	// the last state once it is cleared
+	bool strobe = latch.Ports.Controller;
 	latch.Raw = val;
+	if (!strobe && !latch.Ports.Controller)
+		return;
+
+	for (int port = 0; port < 2; port++)
+	{
+		if (connectedDevices[port])
+			Reload(port);
+	}
 }
 
 Byte ControllerPort::Read(Word addr)
@@ -28,14 +46,33 @@ Byte ControllerPort::Read(Word addr)
 	if (connectedDevices[addr & 1] == nullptr)
 		return 0x00;
 
+	// While strobed, every read returns the first button
+	if (latch.Ports.Controller)
+		Reload(addr & 1);
+
 	return connectedDevices[addr & 1]->CLK();
 }
 
-void ControllerPort::Tick()
+void ControllerPort::Serialize(SaveState& state) const
 {
+	state.Write(latch);
+	state.Write(input);
+
+	for (const Controller* controller : connectedDevices)
+	{
+		if (controller)
+			controller->Serialize(state);
+	}
+}
+
+void ControllerPort::Deserialize(SaveState& state)
+{
+	state.Read(latch);
+	state.Read(input);
+
 	for (Controller* controller : connectedDevices)
 	{
 		if (controller)
-			controller->OUT(latch);
+			controller->Deserialize(state);
 	}
 }
@@ -5,6 +5,7 @@
 #include <type_traits>
 #include "Types.hpp"
 
+#include "InputSource.hpp"
 #include "controllers/Controller.hpp"
 
 class ControllerPort
@@ -13,12 +14,28 @@ class ControllerPort
 
 public:
 	ControllerPort();
+
+	/**
+	 * @brief Plug in copies of the other port's controllers.
+	 */
+	ControllerPort(const ControllerPort& other);
+	ControllerPort& operator=(const ControllerPort&) = delete;
 	~ControllerPort();
 
 	void Write(Byte val);
 	Byte Read(Word addr);
 
-	void Tick();
+	/**
+	 * @brief Replace the buttons the controllers load when they are strobed.
+	 */
+	inline void SetInput(const InputState& state) { input = state; }
+
+	/**
+	 * @brief Save the strobe latch, the buttons and the state of the connected controllers.
+	 * The same controllers have to be plugged in when the state is restored
+	 */
+	void Serialize(SaveState& state) const;
+	void Deserialize(SaveState& state);
 
 	template<
 		typename T,
@@ -29,7 +46,14 @@ public:
 		connectedDevices[port] = new T;
 	}
 
+private:
+	/**
+	 * @brief Load the current buttons into the controller on the given port.
+	 */
+	inline void Reload(int port) { connectedDevices[port]->Reload(input.Ports[port]); }
+
 private:
 	PortLatch latch;
+	InputState input;
 	std::array<Controller*, 2> connectedDevices;
 };
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include "Types.hpp"
+
+/**
+ * @brief Receives the frames drawn by the PPU.
+ *
+ * The PPU writes the pixels of a frame into the sink's buffer while it draws it, and
+ * notifies the sink once the frame is complete. The sink itself doesn't need to display
+ * anything, so the emulation can run without a window or graphics context.
+ */
+class FrameSink
+{
+public:
+	FrameSink() : pixels(256 * 240) {}
+	virtual ~FrameSink() {}
+
+	/**
+	 * @brief Set a pixel to an NES color.
+	 * Bits 0-5 are the index into the system palette, bits 6-8 are the color emphasis bits
+	 */
+	inline void SetPixel(uint16_t x, uint16_t y, Word color) { pixels[y * 256 + x] = color; }
+
+	/**
+	 * @brief The current frame as NES colors.
+	 */
+	inline const std::vector<Word>& GetPixels() const { return pixels; }
+
+	/**
+	 * @brief Called when the PPU finished drawing a frame.
+	 * Skipped frames (see PPU::SetFrameSkip()) aren't reported
+	 */
+	virtual void FrameDone() {}
+
+protected:
+	std::vector<Word> pixels;
+};
@@ -0,0 +1,181 @@
+#include "HeadlessRunner.hpp"
+
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+
+#include "Log.hpp"
+#include "Bus.hpp"
+#include "FrameSink.hpp"
+#include "RunAhead.hpp"
+#include "ThreadPool.hpp"
+
+constexpr HeadlessRunner::CRCTable HeadlessRunner::CreateCRCTable()
+{
+	CRCTable table{};
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t crc = i;
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+
+		table[i] = crc;
+	}
+
+	return table;
+}
+
+constexpr HeadlessRunner::CRCTable HeadlessRunner::CRC = HeadlessRunner::CreateCRCTable();
+
+uint32_t HeadlessRunner::HashFrame(const std::vector<Word>& pixels)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	for (Word color : pixels)
+	{
+		crc = CRC[(crc ^ (color & 0xFF)) & 0xFF] ^ (crc >> 8);
+		crc = CRC[(crc ^ (color >> 8)) & 0xFF] ^ (crc >> 8);
+	}
+
+	return ~crc;
+}
+
+int HeadlessRunner::Launch(const char* rom, const Options& options)
+{
+	FrameSink screen;
+	Bus* bus = nullptr;
+	try
+	{
+		bus = new Bus(rom, &screen);
+	}
+	catch (const std::runtime_error& err)
+	{
+		LOG_CORE_FATAL(err.what());
+		return -1;
+	}
+
+	bus->EnableScanlineRenderer(options.ScanlineRenderer);
+
+	std::ofstream hashes;
+	if (options.HashFile != nullptr)
+	{
+		hashes.open(options.HashFile);
+		if (!hashes.is_open())
+		{
+			LOG_CORE_FATAL("Failed to open {0}", options.HashFile);
+			delete bus;
+			return -1;
+		}
+	}
+
+	LOG_CORE_INFO("Running {0} frames headless, {1} frames ahead", options.Frames, options.RunAheadFrames);
+
+	RunAhead runner(bus, options.RunAheadFrames);
+	uint64_t frame = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (; frame < options.Frames && !bus->IsHalted(); frame++)
+	{
+		runner.Frame();
+
+		if (hashes.is_open())
+		{
+			char line[32];
+			snprintf(line, sizeof(line), "%llu %08x\n", (unsigned long long)frame, HashFrame(screen.GetPixels()));
+			hashes << line;
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	uint64_t instructions = bus->GetExecutedInstructions();
+	bool halted = bus->IsHalted();
+	delete bus;
+
+	double fps = frame / seconds;
+	LOG_CORE_INFO("{0} frames in {1:.3f}s", frame, seconds);
+	LOG_CORE_INFO("{0:.1f} fps, {1:.2f} million instructions per second, {2:.2f}x real time",
+		fps, instructions / seconds / 1e6, fps / NTSCFramerate);
+
+	if (halted)
+	{
+		LOG_CORE_ERROR("The CPU halted after {0} frames", frame);
+		return -1;
+	}
+
+	return 0;
+}
+
+int HeadlessRunner::LaunchParallel(const char* rom, const Options& options, size_t instances, size_t threads)
+{
+	struct Result
+	{
+		uint64_t Frames = 0;
+		uint32_t LastHash = 0;
+		bool Failed = false;
+	};
+
+	std::vector<Result> results(instances);
+	ThreadPool pool(threads);
+	LOG_CORE_INFO("Running {0} instances for {1} frames each on {2} threads", instances, options.Frames, pool.GetThreadCount());
+
+	auto start = std::chrono::steady_clock::now();
+	for (Result& result : results)
+	{
+		pool.Submit([&result, rom, &options]()
+		{
+			try
+			{
+				FrameSink screen;
+				Bus bus(rom, &screen);
+				bus.EnableScanlineRenderer(options.ScanlineRenderer);
+				for (; result.Frames < options.Frames && !bus.IsHalted(); result.Frames++)
+					bus.Frame();
+
+				result.LastHash = HashFrame(screen.GetPixels());
+				result.Failed = bus.IsHalted();
+			}
+			catch (const std::exception& err)
+			{
+				LOG_CORE_ERROR(err.what());
+				result.Failed = true;
+			}
+			catch (...)
+			{
+				LOG_CORE_ERROR("Instance failed with an unknown exception");
+				result.Failed = true;
+			}
+		});
+	}
+
+	pool.Wait();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	uint64_t totalFrames = 0;
+	bool failed = false;
+	bool sameLength = true;
+	bool identical = true;
+	for (const Result& result : results)
+	{
+		totalFrames += result.Frames;
+		failed |= result.Failed;
+		sameLength &= (result.Frames == results[0].Frames);
+		identical &= (result.LastHash == results[0].LastHash);
+	}
+
+	double fps = totalFrames / seconds;
+	LOG_CORE_INFO("{0} frames in {1:.3f}s", totalFrames, seconds);
+	LOG_CORE_INFO("{0:.1f} fps combined, {1:.1f} fps per instance, {2:.2f}x real time combined",
+		fps, fps / instances, fps / NTSCFramerate);
+
+	if (!sameLength)
+		LOG_CORE_WARN("The instances didn't all run the same number of frames");
+	else if (!identical)
+		LOG_CORE_WARN("The instances didn't all draw the same last frame");
+
+	if (failed)
+	{
+		LOG_CORE_ERROR("At least one instance failed");
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include <cstdint>
+#include "Types.hpp"
+
+/**
+ * @brief Runs a ROM for a fixed number of frames without a window.
+ *
+ * Used for regression and performance runs on machines without a display. At the
+ * end it reports the emulated frames and instructions per second, and how much faster
+ * than a real NES that was. Optionally the CRC32 of every frame is written to a file,
+ * one "<frame> <crc32>" line per frame. Diffing the files of two runs, e.g. one with
+ * each renderer, shows the first frame they disagree on.
+ */
+class HeadlessRunner
+{
+public:
+	struct Options
+	{
+		uint64_t Frames = 600;
+		const char* HashFile = nullptr;	//< Only used by Launch()
+		uint32_t RunAheadFrames = 0;	//< Only used by Launch()
+		bool ScanlineRenderer = true;	//< Draw whole scanlines when possible, or every dot on its own
+	};
+
+public:
+	/**
+	 * @brief Run the ROM and report the results.
+	 * With run-ahead the hashed frames are the ones that would be shown (see RunAhead).
+	 * Returns the exit code for the process
+	 */
+	static int Launch(const char* rom, const Options& options);
+
+	/**
+	 * @brief Run several independent instances of the ROM on a thread pool.
+	 * Reports the combined frames per second, and whether all instances ended on the same frame.
+	 * 0 threads uses one per hardware thread. Returns the exit code for the process
+	 */
+	static int LaunchParallel(const char* rom, const Options& options, size_t instances, size_t threads = 0);
+
+	/**
+	 * @brief CRC32 (IEEE) of a frame, every color is hashed as two little endian bytes.
+	 */
+	static uint32_t HashFrame(const std::vector<Word>& pixels);
+
+private:
+	using CRCTable = std::array<uint32_t, 256>;
+
+	/**
+	 * @brief Create the lookup table for the reflected CRC32 polynomial.
+	 */
+	static constexpr CRCTable CreateCRCTable();
+
+private:
+	static const CRCTable CRC;
+	static constexpr double NTSCFramerate = 60.0988;
+};
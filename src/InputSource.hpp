@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include "Types.hpp"
+
+/**
+ * @brief Snapshot of the buttons held on both controller ports.
+ * The emulation only ever reads it, a new snapshot is taken once per frame
+ */
+struct InputState
+{
+	std::array<Byte, 2> Ports{};	//< Buttons in the order the controller shifts them out, first one in bit 7
+};
+
+/**
+ * @brief Provides the buttons held on the controllers.
+ *
+ * The bus samples its input source once per frame when VBlank starts. This lets the
+ * frontend decide where input comes from (keyboard, recorded replays, ...).
+ */
+class InputSource
+{
+public:
+	virtual ~InputSource() {}
+
+	virtual InputState Sample() = 0;
+};
@@ -1,10 +1,18 @@
 #include "Log.hpp"
 #include "spdlog/sinks/stdout_color_sinks.h"
 
+#include <mutex>
+
 std::shared_ptr<spdlog::logger> Log::coreLogger;
 std::shared_ptr<spdlog::logger> Log::debugLogger;
 
 void Log::Init()
+{
+	static std::once_flag initialized;
+	std::call_once(initialized, CreateLoggers);
+}
+
+void Log::CreateLoggers()
 {
 	debugLogger = spdlog::stdout_color_mt("DEBUG");
 	debugLogger->set_pattern("%^[%T] %n: %v%$");
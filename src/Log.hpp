@@ -5,12 +5,22 @@
 
 #define FORCE_NO_DEBUG_LOG
 
+/**
+ * @brief The process wide loggers.
+ * They are shared by all emulator instances, logging from several threads at once is safe
+ */
 class Log
 {
 public:
+	/**
+	 * @brief Create the loggers, only the first call does anything.
+	 */
 	static void Init();
-	inline static std::shared_ptr<spdlog::logger> GetCoreLogger() { return coreLogger; }
-	inline static std::shared_ptr<spdlog::logger> GetDebugLogger() { return debugLogger; }
+	inline static const std::shared_ptr<spdlog::logger>& GetCoreLogger() { return coreLogger; }
+	inline static const std::shared_ptr<spdlog::logger>& GetDebugLogger() { return debugLogger; }
+
+private:
+	static void CreateLoggers();
 
 private:
 	static std::shared_ptr<spdlog::logger> coreLogger;
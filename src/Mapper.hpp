@@ -1,19 +1,53 @@
 #pragma once
 
 #include <vector>
+#include <array>
+#include <memory>
 #include "../Log.hpp"
 #include "Types.hpp"
+#include "TileCache.hpp"
+#include "SaveState.hpp"
 
 class Mapper
 {
 	friend class Disassembler;
 	friend class PatternTableViewer;
 
+public:
+	static constexpr Word PRGStart = 0x6000;						//< Cartridge space starts here, PRG RAM and PRG ROM
+	static constexpr size_t PRGPageCount = (0x10000 - PRGStart) >> 8;	//< Pages (256 bytes each) up to $FFFF
+
 public:
 	virtual ~Mapper() {}
 
-	virtual Byte ReadCPU(Word addr) = 0;
-	virtual Byte ReadPPU(Word addr) = 0;
+	/**
+	 * @brief Create a copy for a cloned machine (see Bus::Clone()).
+	 * The copy shares the ROM with this mapper, registers and writable memory are copied
+	 */
+	virtual Mapper* Clone() const = 0;
+
+	/**
+	 * @brief Read from PRG ROM or PRG RAM ($6000-$FFFF).
+	 * This only goes through the PRG page table, so mappers just need to keep that up to date.
+	 * Pages the cartridge doesn't map read as 0
+	 */
+	inline Byte ReadCPU(Word addr)
+	{
+		const Byte* page = prgPages[PRGPageIndex(addr)];
+		return page ? page[addr & 0xFF] : 0x00;
+	}
+
+	/**
+	 * @brief Read from the pattern tables.
+	 * This only goes through the CHR page table, so mappers just need to keep that up to date
+	 */
+	inline Byte ReadPPU(Word addr) { return (*CHR_ROM)[CHROffset(addr)]; }
+
+	/**
+	 * @brief Get the decoded tile row at the given pattern table address.
+	 */
+	inline const TileCache::Row& ReadTileRow(Word addr) { return tileCache.GetRow(CHROffset(addr)); }
+
 	virtual void WriteCPU(Word addr, Byte val) = 0;
 	virtual void WritePPU(Word addr, Byte val) = 0;
 
@@ -44,15 +78,99 @@ public:
 	virtual Byte ReadVRAM(Word) { return 0x00; }
 	virtual void WriteVRAM(Word, Byte) {}
 
+	/**
+	 * @brief Identifies the current PRG bank configuration.
+	 * Changes whenever different PRG banks are mapped into the CPU address space,
+	 * the CPU uses this to invalidate its decoded instructions
+	 */
+	inline uint32_t GetPRGBankConfiguration() const { return prgBankConfiguration; }
+
+	/**
+	 * @brief The pages (256 bytes each) mapped to $6000-$FFFF, nullptr where nothing is mapped.
+	 */
+	inline const std::array<const Byte*, PRGPageCount>& GetPRGPages() const { return prgPages; }
+
+	/**
+	 * @brief The writable pages (PRG RAM) in $6000-$FFFF, nullptr where writes go to the mapper.
+	 */
+	inline const std::array<Byte*, PRGPageCount>& GetPRGWritePages() const { return prgWritePages; }
+
+	inline TileCache& GetTileCache() { return tileCache; }
+	inline const TileCache& GetTileCache() const { return tileCache; }
+
+	/**
+	 * @brief Save the registers and writable memory of the cartridge.
+	 */
+	virtual void Serialize(SaveState&) const {}
+
+	/**
+	 * @brief Restore the registers and writable memory of the cartridge.
+	 * Mappers have to rebuild their page tables, and switching PRG banks this way has
+	 * to be reported through PRGBanksSwitched() like any other bank switch
+	 */
+	virtual void Deserialize(SaveState&) {}
+
 protected:
-	Mapper(const Header& header) : header(header), prgBanks(header.PrgROM), chrBanks(header.ChrROM)
+	Mapper(const Header& header) : prgBanks(header.PrgROM), chrBanks(header.ChrROM), header(header)
+	{
+	}
+
+	/**
+	 * @brief Map the page at the given CPU address ($6000-$FFFF) to the given offset into PRG ROM.
+	 * Writes to the page go to WriteCPU()
+	 */
+	inline void MapPRGPage(Word addr, size_t offset)
+	{
+		prgPages[PRGPageIndex(addr)] = PRG_ROM->data() + offset;
+		prgWritePages[PRGPageIndex(addr)] = nullptr;
+	}
+
+	/**
+	 * @brief Map the page at the given CPU address ($6000-$FFFF) to 256 bytes of PRG RAM.
+	 * The CPU reads and writes the memory directly. The memory belongs to the mapper, so
+	 * clones have to map their own copy of it
+	 */
+	inline void MapPRGRAMPage(Word addr, Byte* memory)
 	{
+		prgPages[PRGPageIndex(addr)] = memory;
+		prgWritePages[PRGPageIndex(addr)] = memory;
 	}
 
+	/**
+	 * @brief Mappers must call this after switching PRG banks.
+	 */
+	inline void PRGBanksSwitched() { prgBankConfiguration++; }
+
+	/**
+	 * @brief Map the 1KB page at the given PPU address to the given offset into CHR memory.
+	 */
+	inline void MapCHRPage(Word addr, size_t offset) { chrPages[(addr >> 10) & 0x7] = offset; }
+
+	/**
+	 * @brief Index into the PRG page tables of the given CPU address ($6000-$FFFF).
+	 */
+	static inline size_t PRGPageIndex(Word addr) { return (addr - PRGStart) >> 8; }
+
+	/**
+	 * @brief Offset into CHR memory of the given pattern table address.
+	 */
+	inline size_t CHROffset(Word addr) const { return chrPages[(addr >> 10) & 0x7] + (addr & 0x3FF); }
+
 protected:
-	std::vector<Byte> PRG_ROM;
-	std::vector<Byte> CHR_ROM;
+	// ROM is shared between clones of a mapper and never written to. Mappers with CHR RAM
+	// have to give their clones a copy of it
+	std::shared_ptr<const std::vector<Byte>> PRG_ROM;
+	std::shared_ptr<std::vector<Byte>> CHR_ROM;
 	Byte prgBanks = 0;
 	Byte chrBanks = 0;
 	Header header;
+
+	// Decoded tiles are keyed by their offset into CHR memory, so switching banks doesn't invalidate them
+	TileCache tileCache;
+
+private:
+	std::array<const Byte*, PRGPageCount> prgPages{};
+	std::array<Byte*, PRGPageCount> prgWritePages{};
+	std::array<size_t, 8> chrPages{};
+	uint32_t prgBankConfiguration = 1;
 };
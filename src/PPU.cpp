@@ -2,7 +2,10 @@
 #include "Log.hpp"
 #include "Bus.hpp"
 
-#include "gfx/Screen.hpp"
+#include <algorithm>
+
+#include "FrameSink.hpp"
+#include "SaveState.hpp"
 
 const std::vector<Color> PPU::colorTable = {
 	{84,	84,		84 },
@@ -74,12 +77,118 @@ const std::vector<Color> PPU::colorTable = {
 	{0,		0,		0 }
 };
 
-PPU::PPU(Bus* bus, Screen* screen) :
-	bus(bus), screen(screen), ppuctrl{ 0 }, ppustatus{ 0 }
+constexpr std::array<PPU::DotTable, (size_t)PPU::LineVariant::Count> PPU::CreateDotTables()
+{
+	std::array<DotTable, (size_t)LineVariant::Count> tables{};
+
+	for (size_t variant = 0; variant < tables.size(); variant++)
+	{
+		LineVariant line = (LineVariant)variant;
+		bool visible = (line == LineVariant::Visible);
+		bool rendering = (visible || line == LineVariant::PreRender);
+
+		for (Word x = 0; x <= 340; x++)
+		{
+			Dot& dot = tables[variant][x];
+
+			switch (line)
+			{
+			case LineVariant::Visible:		dot.Scanline = ScanlineType::Visible; break;
+			case LineVariant::PostRender:	dot.Scanline = ScanlineType::PostRender; break;
+			case LineVariant::PreRender:	dot.Scanline = ScanlineType::PreRender; break;
+			default:						dot.Scanline = ScanlineType::VBlank; break;
+			}
+
+			dot.Cycle =
+				(x == 0) ? CycleType::Idle :
+				(x <= 256) ? CycleType::Fetching :
+				(x <= 320) ? CycleType::SpriteFetching :
+				(x <= 336) ? CycleType::PreFetching :
+				CycleType::UnknownFetching;
+
+			// Every fetch takes two dots, the memory access happens on the second one
+			Byte fetch = ((x - 2) >> 1) & 0x3;
+			bool fetchDot = (x != 0 && (x & 1) == 0);
+			dot.Phase = (rendering && x < 337) ? (FetchingPhase)((x >> 1) & 0x3) : FetchingPhase::NametableByte;
+
+			uint32_t actions = 0;
+			if (dot.Cycle == CycleType::Fetching || dot.Cycle == CycleType::PreFetching)
+				actions |= ShiftBackground;
+
+			if (rendering)
+			{
+				if (fetchDot)
+				{
+					switch (dot.Cycle)
+					{
+					case CycleType::Fetching:
+					case CycleType::PreFetching:
+					{
+						const uint32_t backgroundFetches[] = { FetchNametable, FetchAttribute, FetchPatternLo, FetchPatternHi };
+						actions |= backgroundFetches[fetch];
+					} break;
+
+					case CycleType::SpriteFetching:
+					{
+						const uint32_t spriteFetches[] = { FetchNametable | LoadSpriteCounter, FetchAttribute | LoadSpriteLatch, FetchSpriteLo, FetchSpriteHi };
+						actions |= spriteFetches[fetch];
+					} break;
+
+					// Only nametable bytes are fetched at the end of the scanline
+					default:
+						actions |= FetchNametable;
+						break;
+					}
+				}
+
+				if (x == 0)
+					actions |= ResetSpriteIndex;
+
+				// The pre-render scanline doesn't evaluate sprites
+				if (visible && x != 0)
+				{
+					actions |= (x <= 64) ? EnableOAMOverride : DisableOAMOverride;
+
+					if (x < 64)
+						actions |= ClearSecondaryOAM;
+					else if (x == 65)
+						actions |= EvaluateSprites;
+				}
+
+				if (dot.Cycle == CycleType::SpriteFetching)
+					actions |= ResetOAMAddress;
+
+				if (x == 257)
+					actions |= CopyHorizontal;
+
+				if (line == LineVariant::PreRender && x >= 280 && x <= 304)
+					actions |= CopyVertical;
+			}
+
+			if (x == 256)
+				actions |= IncrementY;
+
+			if (visible && x < 256)
+				actions |= OutputPixel;
+
+			if (x == 1 && line == LineVariant::VBlankStart)
+				actions |= SetVBlank;
+
+			if (x == 1 && line == LineVariant::PreRender)
+				actions |= ClearVBlank;
+
+			dot.Actions = actions;
+		}
+	}
+
+	return tables;
+}
+
+constexpr std::array<PPU::DotTable, (size_t)PPU::LineVariant::Count> PPU::DotTables = PPU::CreateDotTables();
+
+PPU::PPU(Bus* bus, FrameSink* screen) :
+	ppuctrl{ 0 }, ppustatus{ 0 }, bus(bus), screen(screen)
 {
-	OAM = std::vector<Byte>(64 * 4, 0);
-	secondaryOAM = std::vector<Byte>(8 * 4, 0);
-	sprites = std::vector<Sprite>(8, { 0 });
 }
 
 void PPU::Powerup()
@@ -97,9 +206,9 @@ void PPU::Powerup()
 	fineX = 0;
 	addressLatch = 0;
 
-	scanlineType = ScanlineType::Visible;
-	cycleType = CycleType::Idle;
-	fetchPhase = FetchingPhase::NametableByte;
+	lineVariant = LineVariant::Visible;
+
+	ResolvePalette();
 }
 
 void PPU::Reset()
@@ -115,9 +224,116 @@ void PPU::Reset()
 	fineX = 0;
 	addressLatch = 0;
 
-	scanlineType = ScanlineType::Visible;
-	cycleType = CycleType::Idle;
-	fetchPhase = FetchingPhase::NametableByte;
+	lineVariant = LineVariant::Visible;
+
+	ResolvePalette();
+}
+
+void PPU::Serialize(SaveState& state) const
+{
+	state.Write(ppuctrl);
+	state.Write(ppumask);
+	state.Write(ppustatus);
+	state.Write(ppuscroll);
+	state.Write(ppuaddr);
+	state.Write(oamaddr);
+
+	state.Write(current);
+	state.Write(temporary);
+	state.Write(fineX);
+	state.Write(addressLatch);
+	state.Write(latch);
+
+	state.Write(x);
+	state.Write(y);
+	state.Write(lineVariant);
+	state.Write(nametableByte);
+	state.Write(attributeTableByte);
+	state.Write(patternTableLo);
+	state.Write(patternTableHi);
+	state.Write(loTile);
+	state.Write(hiTile);
+	state.Write(hiAttribute);
+	state.Write(loAttribute);
+
+	state.Write(OAM);
+	state.Write(secondaryOAM);
+	state.Write(sprites);
+	state.Write(OAMOverrideSignal);
+	state.Write(freeSecondaryOAMSlot);
+	state.Write(currentlyEvaluatedSprite);
+
+	state.Write(isFrameDone);
+	state.Write(frameCounter);
+	state.Write(skippingFrame);
+}
+
+void PPU::Deserialize(SaveState& state)
+{
+	state.Read(ppuctrl);
+	state.Read(ppumask);
+	state.Read(ppustatus);
+	state.Read(ppuscroll);
+	state.Read(ppuaddr);
+	state.Read(oamaddr);
+
+	state.Read(current);
+	state.Read(temporary);
+	state.Read(fineX);
+	state.Read(addressLatch);
+	state.Read(latch);
+
+	state.Read(x);
+	state.Read(y);
+	if (x > 340 || y > 261)
+		throw std::runtime_error("Save state contains an invalid PPU position");
+
+	state.ReadEnum(lineVariant, LineVariant::PreRender);
+	state.Read(nametableByte);
+	state.Read(attributeTableByte);
+	state.Read(patternTableLo);
+	state.Read(patternTableHi);
+	state.Read(loTile);
+	state.Read(hiTile);
+	state.Read(hiAttribute);
+	state.Read(loAttribute);
+
+	state.Read(OAM);
+	state.Read(secondaryOAM);
+	state.Read(sprites);
+	for (Byte slot = 0; slot < 8; slot++)
+		DecodeSpriteRow(slot);
+	state.Read(OAMOverrideSignal);
+	state.Read(freeSecondaryOAMSlot);
+	state.Read(currentlyEvaluatedSprite);
+
+	state.Read(isFrameDone);
+	state.Read(frameCounter);
+	state.Read(skippingFrame);
+}
+
+uint32_t PPU::DotsUntilVBlank() const
+{
+	// Dots are counted from the one that will be processed next. The PPU starts at an invalid
+	// position after a reset and wraps to the first dot on the next tick
+	int32_t nextDot = (y > 261) ? 0 : (y * 341 + x + 1);
+	int32_t dotsUntilVBlank = (241 * 341 + 1) - nextDot;
+	if (dotsUntilVBlank < 0)
+		dotsUntilVBlank += 262 * 341;
+
+	return dotsUntilVBlank;
+}
+
+uint32_t PPU::IdleDotsAhead() const
+{
+	if (y > 261)
+		return 0;
+
+	int32_t nextDot = y * 341 + x + 1;
+	if (nextDot < 240 * 341 || nextDot >= 261 * 341)
+		return 0;
+
+	return 261 * 341 - nextDot;
 }
 
 void PPU::Tick()
@@ -130,31 +346,39 @@ void PPU::Tick()
 		y++;
 		if (y > 261)
 			y = 0;
+
+		lineVariant = GetLineVariant(y);
 	}
 
-	UpdateState();
+	uint32_t actions = DotTables[(size_t)lineVariant][x].Actions;
 
 	// On this cycle the VBlankStarted bit is set in the ppustatus
-	if (y == 241 && x == 1)
+	if (actions & SetVBlank)
 	{
 		// Set flag and send NMI if necessary
-		// std::fill(OAM.begin(), OAM.end(), 0x00);
-
 		ppustatus.Flag.VBlankStarted = 1;
 		if (ppuctrl.Flag.VBlankNMI)
 			bus->NMI();
 
 		isFrameDone = true;
+
+		// Decide whether the next frame is drawn
+		lastFrameDrawn = IsDrawing();
+		if (lastFrameDrawn)
+			screen->FrameDone();
+
+		frameCounter++;
+		skippingFrame = (frameCounter % frameSkip != 0);
 	}
 
 	// This cycle resets the VBlankStarted flag
-	if (y == 261 && x == 1)
+	if (actions & ClearVBlank)
 	{
 		ppustatus.Flag.VBlankStarted = 0;
 		ppustatus.Flag.SpriteZeroHit = 0;
 	}
 
-	if (cycleType == CycleType::Fetching || cycleType == CycleType::PreFetching)
+	if (actions & ShiftBackground)
 	{
 		loTile.Raw <<= 1;
 		hiTile.Raw <<= 1;
@@ -162,58 +386,380 @@ void PPU::Tick()
 		hiAttribute.Raw <<= 1;
 	}
 
-	// Need to render
-	if (scanlineType == ScanlineType::Visible || scanlineType == ScanlineType::PreRender)
+	// Memory fetches (background tiles, or garbage nametable fetches while fetching sprites)
+	if (actions & FetchNametable)
+		nametableByte = Read(NametableAddress());
+
+	if (actions & FetchAttribute)
+		attributeTableByte = Read(AttributeAddress());
+
+	if (actions & FetchPatternLo)
+		patternTableLo = Read(BackgroundPatternAddress());
+
+	if (actions & FetchPatternHi)
+	{
+		patternTableHi = Read(BackgroundPatternAddress() + 8);
+
+		loTile.Bytes.Lo = patternTableLo;
+		hiTile.Bytes.Lo = patternTableHi;
+
+		Byte palette = AttributePalette();
+		loAttribute.Bytes.Lo = ((palette & 1) ? 0xFF : 0x00);
+		hiAttribute.Bytes.Lo = ((palette & 2) ? 0xFF : 0x00);
+
+		IncrementCoarseX();
+	}
+
+	// Sprite evaluation
+	if (actions & ResetSpriteIndex)
+		currentlyEvaluatedSprite = 0x00;
+
+	if (actions & EnableOAMOverride)
+		OAMOverrideSignal = 0xFF;
+
+	if (actions & DisableOAMOverride)
+		OAMOverrideSignal = 0x00;
+
+	if (actions & ClearSecondaryOAM)
+		secondaryOAM[x >> 1] = ReadOAM(0x00);
+
+	// Just do it all at once
+	if (actions & EvaluateSprites)
+		EvaluateSecondaryOAM();
+
+	if (actions & ResetOAMAddress)
+		oamaddr = 0;
+
+	// Sprite tile fetches
+	if (actions & LoadSpriteCounter)
+	{
+		sprites[currentlyEvaluatedSprite].Counter = secondaryOAM[4 * currentlyEvaluatedSprite + 3];
+		sprites[currentlyEvaluatedSprite].FineX = 0;
+	}
+
+	if (actions & LoadSpriteLatch)
+		sprites[currentlyEvaluatedSprite].Latch.Raw = secondaryOAM[4 * currentlyEvaluatedSprite + 2];
+
+	if (actions & FetchSpriteLo)
+		sprites[currentlyEvaluatedSprite].Lo = Read(SpritePatternAddress(currentlyEvaluatedSprite, false));
+
+	if (actions & FetchSpriteHi)
+	{
+		sprites[currentlyEvaluatedSprite].Hi = Read(SpritePatternAddress(currentlyEvaluatedSprite, true));
+
+		if (currentlyEvaluatedSprite * 4 >= freeSecondaryOAMSlot)
+		{
+			sprites[currentlyEvaluatedSprite].Lo = 0x00;
+			sprites[currentlyEvaluatedSprite].Hi = 0x00;
+		}
+
+		DecodeSpriteRow(currentlyEvaluatedSprite);
+		currentlyEvaluatedSprite++;
+	}
+
+	// Scrolling
+	if (actions & CopyHorizontal)
+		CopyHorizontalScroll();
+
+	if ((actions & CopyVertical) && ppumask.Flag.ShowBackground)
+		CopyVerticalScroll();
+
+	if (actions & IncrementY)
+		IncrementFineY();
+
+	if (actions & OutputPixel)
 	{
-		EvaluateBackgroundTiles();
-		EvaluateSprites();
+		if (IsDrawing())
+		{
+			Pixel bgPixel = GetBackgroundPixel();
+			Pixel spritePixel = GetSpritePixel();
 
-		if (x == 257)
+			Word pixel = MultiplexPixel(bgPixel, spritePixel);
+			screen->SetPixel(x, y, pixel);
+		}
+		else
 		{
-			current.Data.CoarseX = temporary.Data.CoarseX;
-			current.Data.NametableSel &= 0x2;
-			current.Data.NametableSel |= temporary.Data.NametableSel & 0x1;
+			// The sprites still have to move on, and sprite 0 hits can't be skipped
+			Pixel spritePixel = GetSpritePixel();
+			if (spritePixel.isZeroSprite && GetBackgroundPixel().color != 0x00)
+				DetectSpriteZeroHit();
 		}
+	}
+}
 
-		if (scanlineType == ScanlineType::PreRender && ppumask.Flag.ShowBackground && x >= 280 && x <= 304)
+void PPU::Run(uint64_t dots)
+{
+	while (dots > 0)
+	{
+		if (scanlineRenderer && dots >= 341 && CanRenderScanline())
+		{
+			RenderScanline();
+			dots -= 341;
+		}
+		else if (uint64_t skipped = (scanlineRenderer ? SkipIdleDots(dots) : 0))
 		{
-			current.Data.FineY = temporary.Data.FineY;
-			current.Data.CoarseY = temporary.Data.CoarseY;
-			current.Data.NametableSel &= 0x1;
-			current.Data.NametableSel |= temporary.Data.NametableSel & 0x2;
+			dots -= skipped;
 		}
+		else
+		{
+			Tick();
+			dots--;
+		}
+	}
+}
 
+bool PPU::CanRenderScanline() const
+{
+	// The next dot has to start a visible scanline
+	if (x < 340)
+		return false;
+
+	Word nextY = (y >= 261) ? 0 : y + 1;
+	return nextY < 240;
+}
+
+void PPU::RenderScanline()
+{
+	y = (y >= 261) ? 0 : y + 1;
+	lineVariant = LineVariant::Visible;
+
+	// Reads from PPU memory have no side effects, and nothing can write to it during
+	// the scanline, so all background tiles of the scanline can be fetched up front.
+	// Tiles are handled as packed rows of 8 pixels, every pixel is (palette << 2) | color.
+	// The first two tiles were already prefetched into the shift registers on the previous scanline
+	uint64_t backgroundTiles[34];
+	backgroundTiles[0] = TileCache::ExpandPlanes(loTile.Bytes.Hi, hiTile.Bytes.Hi) | (TileCache::ExpandPlanes(loAttribute.Bytes.Hi, hiAttribute.Bytes.Hi) << 2);
+	backgroundTiles[1] = TileCache::ExpandPlanes(loTile.Bytes.Lo, hiTile.Bytes.Lo) | (TileCache::ExpandPlanes(loAttribute.Bytes.Lo, hiAttribute.Bytes.Lo) << 2);
+
+	for (int tile = 2; tile < 34; tile++)
+	{
+		nametableByte = Read(NametableAddress());
+		attributeTableByte = Read(AttributeAddress());
+
+		const TileCache::Row& row = bus->ReadTileRow(BackgroundPatternAddress());
+		backgroundTiles[tile] = TileCache::Pack(row) | ((AttributePalette() * 0x0101010101010101ull) << 2);
+
+		IncrementCoarseX();
 	}
-	
-	if (x == 256)
+
+	// Transparent pixels use the backdrop color, so drop their palette. The fine X scroll
+	// is applied when reading from the line
+	Byte backgroundLine[34 * 8] = { 0 };
+	if (ppumask.Flag.ShowBackground)
 	{
-		current.Data.FineY++;
-		if (current.Data.FineY == 0)
+		for (int tile = 0; tile < 34; tile++)
 		{
-			if (current.Data.CoarseY == 29)
-			{
-				current.Data.CoarseY = 0;
-				current.Data.NametableSel ^= 0x2;
-			}
-			else if (current.Data.CoarseY == 31)
-			{
-				current.Data.CoarseY = 0;
-			}
-			else
-			{
-				current.Data.CoarseY++;
-			}
+			uint64_t opaque = (backgroundTiles[tile] | (backgroundTiles[tile] >> 1)) & 0x0101010101010101ull;
+			TileCache::Unpack(backgroundTiles[tile] & (opaque * 0x0F), backgroundLine + 8 * tile);
 		}
 	}
 
-	if (x < 256 && y < 240)
+	// Sprite evaluation happens on dot 65 and already affects the sprite 0 flag of the
+	// pixels after it
+	ComposeSprites(0, 65);
+	for (x = 0; x < 256; x++)
 	{
-		Pixel bgPixel = GetBackgroundPixel();
-		Pixel spritePixel = GetSpritePixel();
+		if (x == 65)
+		{
+			OAMOverrideSignal = 0x00;
+			std::fill(secondaryOAM.begin(), secondaryOAM.end(), 0xFF);
+			EvaluateSecondaryOAM();
+			ComposeSprites(65, 256);
+		}
+
+		// Only sprite 0 hits are left to do on skipped frames
+		if (!IsDrawing())
+		{
+			if (spriteLine[x].isZeroSprite && (backgroundLine[x + fineX] & 0x3) != 0x00)
+				DetectSpriteZeroHit();
 
-		Color pixel = MultiplexPixel(bgPixel, spritePixel);
+			continue;
+		}
+
+		// The shift registers output the pixel fineX dots after the current one
+		Pixel bgPixel{ 0 };
+		Byte backgroundPixel = backgroundLine[x + fineX];
+		bgPixel.color = backgroundPixel & 0x3;
+		bgPixel.palette = backgroundPixel >> 2;
+
+		Word pixel = MultiplexPixel(bgPixel, spriteLine[x]);
 		screen->SetPixel(x, y, pixel);
 	}
+
+	IncrementFineY();
+	CopyHorizontalScroll();
+
+	// Sprite tile fetches, the garbage nametable fetches in between are overwritten below
+	for (Byte slot = 0; slot < 8; slot++)
+	{
+		Sprite& sprite = sprites[slot];
+		sprite.Counter = secondaryOAM[4 * slot + 3];
+		sprite.FineX = 0;
+		sprite.Latch.Raw = secondaryOAM[4 * slot + 2];
+
+		if (slot * 4 >= freeSecondaryOAMSlot)
+		{
+			sprite.Lo = 0x00;
+			sprite.Hi = 0x00;
+			spriteRows[slot].fill(0);
+			continue;
+		}
+
+		// Tall sprites can address planes that aren't the two halves of one tile row, those are read as they are
+		Word address = SpritePatternAddress(slot, false);
+		if ((address & 0x8) != 0 || SpritePatternAddress(slot, true) != address + 8)
+		{
+			sprite.Lo = Read(address);
+			sprite.Hi = Read(SpritePatternAddress(slot, true));
+			DecodeSpriteRow(slot);
+			continue;
+		}
+
+		// Take the decoded row from the tile cache, the planes are still needed by the dot renderer
+		const TileCache::Row& row = bus->ReadTileRow(address);
+		spriteRows[slot] = row;
+
+		sprite.Lo = 0x00;
+		sprite.Hi = 0x00;
+		for (int i = 0; i < 8; i++)
+		{
+			sprite.Lo |= (row[i] & 0x1) << (7 - i);
+			sprite.Hi |= (row[i] >> 1) << (7 - i);
+		}
+	}
+
+	// Prefetch the first two tiles of the next scanline
+	FetchBackgroundTile();
+	Byte palette = AttributePalette();
+	IncrementCoarseX();
+
+	loTile.Bytes.Hi = patternTableLo;
+	hiTile.Bytes.Hi = patternTableHi;
+	loAttribute.Bytes.Hi = ((palette & 1) ? 0xFF : 0x00);
+	hiAttribute.Bytes.Hi = ((palette & 2) ? 0xFF : 0x00);
+
+	FetchBackgroundTile();
+	palette = AttributePalette();
+	IncrementCoarseX();
+
+	loTile.Bytes.Lo = patternTableLo;
+	hiTile.Bytes.Lo = patternTableHi;
+	loAttribute.Bytes.Lo = ((palette & 1) ? 0xFF : 0x00);
+	hiAttribute.Bytes.Lo = ((palette & 2) ? 0xFF : 0x00);
+
+	nametableByte = Read(NametableAddress());
+
+	// Leave everything the way the last dot of the scanline would
+	x = 340;
+	currentlyEvaluatedSprite = 8;
+	oamaddr = 0;
+}
+
+/**
+ * @brief Number of dots of a scanline up to and including the given one that shift the background registers.
+ */
+static Word ShiftingDotsUntil(int dot)
+{
+	return (dot < 0) ? 0 : (Word)(std::min(dot, 256) + std::min(std::max(dot - 320, 0), 16));
+}
+
+uint64_t PPU::SkipIdleDots(uint64_t dots)
+{
+	uint64_t skipped = 0;
+
+	// After a reset the position is only fixed up by the next tick
+	if (x > 340)
+		return 0;
+
+	while (skipped < dots)
+	{
+		Word firstX = x + 1;
+		Word line = y;
+		if (firstX > 340)
+		{
+			firstX = 0;
+			line = (line >= 261) ? 0 : line + 1;
+		}
+
+		// Idle scanlines only shift the background registers and increment fine Y
+		LineVariant variant = GetLineVariant(line);
+		if (variant != LineVariant::PostRender && variant != LineVariant::VBlankStart && variant != LineVariant::VBlank)
+			break;
+
+		Word lastX = (Word)std::min<uint64_t>(340, firstX + (dots - skipped) - 1);
+		if (variant == LineVariant::VBlankStart && firstX <= 1)
+		{
+			if (firstX == 1)
+				break;
+
+			lastX = 0;
+		}
+
+		// Shifting the registers by 16 or more clears them
+		Word shifts = std::min<Word>(ShiftingDotsUntil(lastX) - ShiftingDotsUntil(firstX - 1), 16);
+		if (shifts != 0)
+		{
+			loTile.Raw <<= shifts;
+			hiTile.Raw <<= shifts;
+			loAttribute.Raw <<= shifts;
+			hiAttribute.Raw <<= shifts;
+		}
+
+		if (firstX <= 256 && lastX >= 256)
+			IncrementFineY();
+
+		x = lastX;
+		y = line;
+		lineVariant = variant;
+		skipped += lastX - firstX + 1;
+	}
+
+	return skipped;
+}
+
+void PPU::ComposeSprites(Word from, Word to)
+{
+	// Same defaults as GetSpritePixel()
+	Pixel transparent{ 0 };
+	transparent.palette = 4;
+	transparent.priority = 1;
+	std::fill(spriteLine.begin() + from, spriteLine.begin() + to, transparent);
+
+	// The sprite counters don't run while sprites are hidden
+	if (!ppumask.Flag.ShowSprites)
+		return;
+
+	// Lower sprites have priority, so draw them last
+	for (int slot = 7; slot >= 0; slot--)
+	{
+		const Sprite& sprite = sprites[slot];
+
+		// The sprite starts once its counter ran out, and continues with its current pixel
+		Word start = std::max<Word>(from, sprite.Counter);
+		Word end = std::min<Word>(to, sprite.Counter + 8 - std::min<Byte>(sprite.FineX, 8));
+		const TileCache::Row& row = spriteRows[slot];
+		for (Word dot = start; dot < end; dot++)
+		{
+			Byte fineX = sprite.FineX + (dot - sprite.Counter);
+			Byte color = row[sprite.Latch.Data.FlipHorizontally ? (7 - fineX) : fineX];
+			if (color == 0x00)
+				continue;
+
+			Pixel& pixel = spriteLine[dot];
+			pixel.color = color;
+			pixel.palette = 4 + sprite.Latch.Data.Palette;
+			pixel.priority = sprite.Latch.Data.Priority;
+			pixel.isZeroSprite = (sprite.OAMPosition == 0x00);
+		}
+	}
+}
+
+void PPU::FetchBackgroundTile()
+{
+	nametableByte = Read(NametableAddress());
+	attributeTableByte = Read(AttributeAddress());
+	patternTableLo = Read(BackgroundPatternAddress());
+	patternTableHi = Read(BackgroundPatternAddress() + 8);
 }
 
 Byte PPU::ReadRegister(Byte id)
@@ -281,6 +827,7 @@ void PPU::WriteRegister(Byte id, Byte val)
 
 	case 1:
 		ppumask.Raw = val;
+		ResolvePalette();
 		break;
 
 	case 2:
@@ -358,6 +905,15 @@ void PPU::WriteOAM(Byte offset, Byte val)
 	OAM[offset] = val;
 }
 
+void PPU::WriteOAMPage(const Byte* data)
+{
+	// The writes wrap around and leave OAMADDR where it started
+	std::copy(data, data + (0x100 - oamaddr), OAM.begin() + oamaddr);
+	std::copy(data + (0x100 - oamaddr), data + 0x100, OAM.begin());
+
+	ppustatus.Flag.Unused = data[0xFF] & 0x1F;
+}
+
 Byte PPU::Read(Word addr)
 {
 	return bus->ReadPPU(addr);
@@ -368,239 +924,129 @@ void PPU::Write(Word addr, Byte val)
 	bus->WritePPU(addr, val);
 }
 
-void PPU::UpdateState()
+void PPU::ResolvePalette()
 {
-	switch (y)
-	{
-	case 0:
-		scanlineType = ScanlineType::Visible;
-		break;
-
-	case 240:
-		scanlineType = ScanlineType::PostRender;
-		break;
-
-	case 241:
-		scanlineType = ScanlineType::VBlank;
-		break;
-
-	case 261:
-		scanlineType = ScanlineType::PreRender;
-		break;
-	}
-
-	switch (x)
-	{
-	case 0:
-		cycleType = CycleType::Idle;
-		break;
-
-	case 1:
-		cycleType = CycleType::Fetching;
-		break;
+	// Greyscale mode only keeps the column of grey colors
+	Byte colorMask = ppumask.Flag.Greyscale ? 0x30 : 0x3F;
+	Word emphasis = (Word)(ppumask.Raw & 0xE0) << 1;
 
-	case 257:
-		cycleType = CycleType::SpriteFetching;
-		break;
-
-	case 321:
-		cycleType = CycleType::PreFetching;
-		break;
-
-	case 337:
-		cycleType = CycleType::UnknownFetching;
-		break;
-	}
+	for (Byte entry = 0; entry < 0x20; entry++)
+		resolvedPalette[entry] = (Read(0x3F00 | entry) & colorMask) | emphasis;
 }
 
-void PPU::EvaluateBackgroundTiles()
+void PPU::IncrementCoarseX()
 {
-	if (cycleType == CycleType::Idle)
+	if (current.Data.CoarseX == 0x1F)
 	{
-		return;
+		current.Data.NametableSel ^= 0x1;
+		current.Data.CoarseX = 0x00;
 	}
-
-	if (cycleType == CycleType::SpriteFetching)
-		return;
-
-	if (memoryAccessLatch == 1)
+	else
 	{
-		switch (fetchPhase)
-		{
-		case FetchingPhase::NametableByte:
-			nametableByte = Read(0x2000 | (current.Raw & 0x0FFF));
-
-			if(cycleType != CycleType::UnknownFetching)
-				fetchPhase = FetchingPhase::AttributeTableByte;
-			break;
-
-		case FetchingPhase::AttributeTableByte:
-			attributeTableByte = Read(0x23C0 | (current.Raw & 0x0C00) | ((current.Data.CoarseY >> 2) << 3) | (current.Data.CoarseX >> 2));
-			fetchPhase = FetchingPhase::PatternTableLo;
-			break;
-
-		case FetchingPhase::PatternTableLo:
-			patternTableLo = Read(((Word)ppuctrl.Flag.BackgrPatternTableAddr << 12) | ((Word)nametableByte << 4) + current.Data.FineY);
-			fetchPhase = FetchingPhase::PatternTableHi;
-			break;
-
-		case FetchingPhase::PatternTableHi:
-			patternTableHi = Read((((Word)ppuctrl.Flag.BackgrPatternTableAddr << 12) | ((Word)nametableByte << 4)) + 8 + current.Data.FineY);
-
-			loTile.Bytes.Lo = patternTableLo;
-			hiTile.Bytes.Lo = patternTableHi;
-
-			Byte attributeHalfNybble = attributeTableByte;
-			attributeHalfNybble >>= (((current.Data.CoarseX >> 1) % 2) ? 2 : 0);
-			attributeHalfNybble >>= (((current.Data.CoarseY >> 1) % 2) ? 4 : 0);
-
-			loAttribute.Bytes.Lo = ((attributeHalfNybble & 1) ? 0xFF : 0x00);
-			hiAttribute.Bytes.Lo = ((attributeHalfNybble & 2) ? 0xFF : 0x00);
-
-			if (current.Data.CoarseX == 0x1F)
-			{
-				current.Data.NametableSel ^= 0x1;
-				current.Data.CoarseX = 0x00;
-			}
-			else
-			{
-				current.Data.CoarseX++;
-			}
-
-			fetchPhase = FetchingPhase::NametableByte;
-			break;
-		}
+		current.Data.CoarseX++;
 	}
-
-	memoryAccessLatch = 1 - memoryAccessLatch;
 }
 
-void PPU::EvaluateSprites()
+void PPU::IncrementFineY()
 {
-	if (cycleType == CycleType::Idle)
+	current.Data.FineY++;
+	if (current.Data.FineY == 0)
 	{
-		currentlyEvaluatedSprite = 0x00;
-		return;
-	}
-
-	if (scanlineType != ScanlineType::PreRender)
-	{
-		OAMOverrideSignal = (x <= 64) * 0xFF;
-
-		// Secondary OAM clear
-		if (x < 64)
+		if (current.Data.CoarseY == 29)
 		{
-			secondaryOAM[x >> 1] = ReadOAM(0x00);
-			return;
+			current.Data.CoarseY = 0;
+			current.Data.NametableSel ^= 0x2;
 		}
-
-		// Sprite evaluation (just do it all at once)
-		if (x == 65)
+		else if (current.Data.CoarseY == 31)
 		{
-			freeSecondaryOAMSlot = 0x00;
-
-			Byte n;
-			for (n = 0; n < 64; n++)
-			{
-				if (oamaddr + 4 * n >= 64 * 4)
-					break;
-
-				Byte spriteYCoord = ReadOAM(oamaddr + 4 * n);
-				if (freeSecondaryOAMSlot >= 32)
-					break;
-
-				// Find free slot
-				secondaryOAM[freeSecondaryOAMSlot] = spriteYCoord;
-				Word diff = y - spriteYCoord;
-				if (diff < 8u + ppuctrl.Flag.SpriteSize * 8u)	// Choose between 8x8 and 8x16 mode
-				{
-					secondaryOAM[freeSecondaryOAMSlot + 1] = ReadOAM(oamaddr + 4 * n + 1);
-					secondaryOAM[freeSecondaryOAMSlot + 2] = ReadOAM(oamaddr + 4 * n + 2);
-					secondaryOAM[freeSecondaryOAMSlot + 3] = ReadOAM(oamaddr + 4 * n + 3);
-
-					sprites[freeSecondaryOAMSlot >> 2].OAMPosition = n >> 2;
-
-					freeSecondaryOAMSlot += 4;
-				}
-
-				
-			}
-
-			Byte m = 0;
-			for (; n < 64; n++)
-			{
-				Byte spriteYCoord = ReadOAM(4 * n + m);
-				if (spriteYCoord < 240)
-					ppustatus.Flag.SpriteOverflow = 1;
-				else
-					m = (m + 1) % 4;	// Correctly implement sprite overflow bug
-			}
-
-			return;
+			current.Data.CoarseY = 0;
+		}
+		else
+		{
+			current.Data.CoarseY++;
 		}
 	}
+}
 
-	if (cycleType == CycleType::SpriteFetching)
-	{
-		oamaddr = 0;
-
-		// Sprite tile fetches
-		if (memoryAccessLatch == 1)
-		{
-			switch (fetchPhase)
-			{
-			case FetchingPhase::NametableByte:	// Fetch garbage
-				nametableByte = Read(0x2000 | (current.Raw & 0x0FFF));
-				sprites[currentlyEvaluatedSprite].Counter = secondaryOAM[4 * currentlyEvaluatedSprite + 3];
-				sprites[currentlyEvaluatedSprite].FineX = 0;
+void PPU::CopyHorizontalScroll()
+{
+	current.Data.CoarseX = temporary.Data.CoarseX;
+	current.Data.NametableSel &= 0x2;
+	current.Data.NametableSel |= temporary.Data.NametableSel & 0x1;
+}
 
-				fetchPhase = FetchingPhase::AttributeTableByte;
-				break;
+void PPU::CopyVerticalScroll()
+{
+	current.Data.FineY = temporary.Data.FineY;
+	current.Data.CoarseY = temporary.Data.CoarseY;
+	current.Data.NametableSel &= 0x1;
+	current.Data.NametableSel |= temporary.Data.NametableSel & 0x2;
+}
 
-			case FetchingPhase::AttributeTableByte:	// Fetch garbage
-				attributeTableByte = Read(0x23C0 | (current.Raw & 0x0C00) | ((current.Data.CoarseY >> 2) << 3) | (current.Data.CoarseX >> 2));
-				sprites[currentlyEvaluatedSprite].Latch.Raw = secondaryOAM[4 * currentlyEvaluatedSprite + 2];
+Byte PPU::AttributePalette() const
+{
+	Byte attributeHalfNybble = attributeTableByte;
+	attributeHalfNybble >>= (((current.Data.CoarseX >> 1) % 2) ? 2 : 0);
+	attributeHalfNybble >>= (((current.Data.CoarseY >> 1) % 2) ? 4 : 0);
 
-				fetchPhase = FetchingPhase::PatternTableLo;
-				break;
+	return attributeHalfNybble & 0x3;
+}
 
-			case FetchingPhase::PatternTableLo:
-			{
-				Word spriteFineY = y - secondaryOAM[4 * currentlyEvaluatedSprite];
-				if (sprites[currentlyEvaluatedSprite].Latch.Data.FlipVertically)
-					spriteFineY = 7 - spriteFineY;
+Word PPU::SpritePatternAddress(Byte slot, bool highPlane) const
+{
+	Word spriteFineY = y - secondaryOAM[4 * slot];
+	if (sprites[slot].Latch.Data.FlipVertically)
+		spriteFineY = 7 - spriteFineY;
 
-				Word tileNumber = secondaryOAM[4 * currentlyEvaluatedSprite + 1] + (spriteFineY >> 3);
+	if (highPlane)
+	{
+		Byte tileNumber = secondaryOAM[4 * slot + 1] + Byte((spriteFineY >> 3) & 0xFF);
+		return (((Word)ppuctrl.Flag.SpritePatternTableAddr << 12) | (tileNumber << 4)) + 8 + spriteFineY;
+	}
 
-				sprites[currentlyEvaluatedSprite].Lo = Read((((Word)ppuctrl.Flag.SpritePatternTableAddr << 12) | (tileNumber << 4)) + spriteFineY);
+	Word tileNumber = secondaryOAM[4 * slot + 1] + (spriteFineY >> 3);
+	return (((Word)ppuctrl.Flag.SpritePatternTableAddr << 12) | (tileNumber << 4)) + spriteFineY;
+}
 
-				fetchPhase = FetchingPhase::PatternTableHi;
-			} break;
+void PPU::EvaluateSecondaryOAM()
+{
+	freeSecondaryOAMSlot = 0x00;
 
-			case FetchingPhase::PatternTableHi:
-			{
-				Word spriteFineY = y - secondaryOAM[4 * currentlyEvaluatedSprite];
-				if (sprites[currentlyEvaluatedSprite].Latch.Data.FlipVertically)
-					spriteFineY = 7 - spriteFineY;
+	Byte n;
+	for (n = 0; n < 64; n++)
+	{
+		if (oamaddr + 4 * n >= 64 * 4)
+			break;
 
-				Byte tileNumber = secondaryOAM[4 * currentlyEvaluatedSprite + 1] + Byte((spriteFineY >> 3) & 0xFF);
+		Byte spriteYCoord = ReadOAM(oamaddr + 4 * n);
+		if (freeSecondaryOAMSlot >= 32)
+			break;
 
-				sprites[currentlyEvaluatedSprite].Hi = Read((((Word)ppuctrl.Flag.SpritePatternTableAddr << 12) | (tileNumber << 4)) + 8 + spriteFineY);
+		// Find free slot
+		secondaryOAM[freeSecondaryOAMSlot] = spriteYCoord;
+		Word diff = y - spriteYCoord;
+		if (diff < 8u + ppuctrl.Flag.SpriteSize * 8u)	// Choose between 8x8 and 8x16 mode
+		{
+			secondaryOAM[freeSecondaryOAMSlot + 1] = ReadOAM(oamaddr + 4 * n + 1);
+			secondaryOAM[freeSecondaryOAMSlot + 2] = ReadOAM(oamaddr + 4 * n + 2);
+			secondaryOAM[freeSecondaryOAMSlot + 3] = ReadOAM(oamaddr + 4 * n + 3);
 
-				if (currentlyEvaluatedSprite * 4 >= freeSecondaryOAMSlot)
-				{
-					sprites[currentlyEvaluatedSprite].Lo = 0x00;
-					sprites[currentlyEvaluatedSprite].Hi = 0x00;
-				}
-				
-				currentlyEvaluatedSprite++;
+			sprites[freeSecondaryOAMSlot >> 2].OAMPosition = n >> 2;
 
-				fetchPhase = FetchingPhase::NametableByte;
-			} break;
-			}
+			freeSecondaryOAMSlot += 4;
 		}
 
-		memoryAccessLatch = 1 - memoryAccessLatch;
+		
+	}
+
+	Byte m = 0;
+	for (; n < 64; n++)
+	{
+		Byte spriteYCoord = ReadOAM(4 * n + m);
+		if (spriteYCoord < 240)
+			ppustatus.Flag.SpriteOverflow = 1;
+		else
+			m = (m + 1) % 4;	// Correctly implement sprite overflow bug
 	}
 }
 
@@ -688,40 +1134,43 @@ Pixel PPU::GetSpritePixel()
 	return returnValue;
 }
 
-Color PPU::MultiplexPixel(Pixel background, Pixel sprite)
+Word PPU::MultiplexPixel(Pixel background, Pixel sprite)
 {
 	if (background.color == 0)
 	{
 		if (sprite.color == 0)
-			return colorTable[Read(0x3F00)];
+			return resolvedPalette[0x00];
 
 		else
-			return colorTable[Read(0x3F00 | (sprite.palette << 2) | sprite.color)];
+			return resolvedPalette[(sprite.palette << 2) | sprite.color];
 	}
 	else
 	{
 		if (sprite.color == 0)
-			return colorTable[Read(0x3F00 | (background.palette << 2) | background.color)];
+			return resolvedPalette[(background.palette << 2) | background.color];
 
 		else
 		{
 			// Sprite Zero hit detection
 			if (sprite.isZeroSprite)
-			{
-				// All of the conditions that make sprite zero hits not evaluate
-				if (!(
-					(!ppustatus.Flag.SpriteZeroHit) &&
-					(x == 255) &&
-					(!ppumask.Flag.ShowBackground || !ppumask.Flag.ShowSprites) &&
-					((!ppumask.Flag.SpriteOnLeft || !ppumask.Flag.BackgroundOnLeft) && 0 <= x && x <= 7)
-				)) ppustatus.Flag.SpriteZeroHit = 1;
-			}
+				DetectSpriteZeroHit();
 
 			if(sprite.priority == 0)
-				return colorTable[Read(0x3F00 | (sprite.palette << 2) | sprite.color)];
+				return resolvedPalette[(sprite.palette << 2) | sprite.color];
 
 			else
-				return colorTable[Read(0x3F00 | (background.palette << 2) | background.color)];
+				return resolvedPalette[(background.palette << 2) | background.color];
 		}
 	}
 }
+
+void PPU::DetectSpriteZeroHit()
+{
+	// All of the conditions that make sprite zero hits not evaluate
+	if (!(
+		(!ppustatus.Flag.SpriteZeroHit) &&
+		(x == 255) &&
+		(!ppumask.Flag.ShowBackground || !ppumask.Flag.ShowSprites) &&
+		((!ppumask.Flag.SpriteOnLeft || !ppumask.Flag.BackgroundOnLeft) && 0 <= x && x <= 7)
+	)) ppustatus.Flag.SpriteZeroHit = 1;
+}
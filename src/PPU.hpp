@@ -1,12 +1,16 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
+#include <array>
 #include "Types.hpp"
+#include "TileCache.hpp"
 
 class Bus;
-class Screen;
+class FrameSink;
+class SaveState;
 
-enum class ScanlineType
+enum class ScanlineType : Byte
 {
 	PreRender,
 	Visible,
@@ -14,7 +18,7 @@ enum class ScanlineType
 	VBlank
 };
 
-enum class CycleType
+enum class CycleType : Byte
 {
 	Idle,
 	Fetching,
@@ -23,7 +27,7 @@ enum class CycleType
 	UnknownFetching
 };
 
-enum class FetchingPhase
+enum class FetchingPhase : Byte
 {
 	NametableByte,
 	AttributeTableByte,
@@ -91,12 +95,72 @@ class PPU
 {
 	friend class PPUWatcher;
 	friend class OAMViewer;
+	friend class NametableViewer;
 
 public:
 	static const std::vector<Color> colorTable;
 
+private:
+	/**
+	 * @brief Scanlines that share the same per-dot table.
+	 */
+	enum class LineVariant : Byte
+	{
+		Visible,
+		PostRender,
+		VBlankStart,	//< First VBlank scanline, the only one that sets the VBlank flag
+		VBlank,
+		PreRender,
+
+		Count
+	};
+
+	/**
+	 * @brief Work the PPU does on a dot, combined as flags in the per-dot tables.
+	 * The flags are handled in the order they are listed in
+	 */
+	enum DotAction : uint32_t
+	{
+		SetVBlank				= 1 << 0,
+		ClearVBlank				= 1 << 1,
+		ShiftBackground			= 1 << 2,
+		FetchNametable			= 1 << 3,
+		FetchAttribute			= 1 << 4,
+		FetchPatternLo			= 1 << 5,
+		FetchPatternHi			= 1 << 6,	//< Also reloads the shift registers and increments coarse X
+		ResetSpriteIndex		= 1 << 7,
+		EnableOAMOverride		= 1 << 8,
+		DisableOAMOverride		= 1 << 9,
+		ClearSecondaryOAM		= 1 << 10,
+		EvaluateSprites			= 1 << 11,
+		ResetOAMAddress			= 1 << 12,
+		LoadSpriteCounter		= 1 << 13,
+		LoadSpriteLatch			= 1 << 14,
+		FetchSpriteLo			= 1 << 15,
+		FetchSpriteHi			= 1 << 16,
+		CopyHorizontal			= 1 << 17,
+		CopyVertical			= 1 << 18,	//< Only if the background is shown
+		IncrementY				= 1 << 19,
+		OutputPixel				= 1 << 20
+	};
+
+	/**
+	 * @brief Everything that happens on one dot of a scanline.
+	 * The scanline type, cycle type and fetching phase aren't needed to run the PPU, they
+	 * are only there to show the state in the debugger
+	 */
+	struct Dot
+	{
+		uint32_t Actions;
+		ScanlineType Scanline;
+		CycleType Cycle;
+		FetchingPhase Phase;	//< Phase of the next memory fetch
+	};
+
+	using DotTable = std::array<Dot, 341>;
+
 public:
-	PPU(Bus* bus, Screen* screen);
+	PPU(Bus* bus, FrameSink* screen);
 
 	/**
 	 * @brief Powerup PPU.
@@ -115,6 +179,37 @@ public:
 	 */
 	void Tick();
 
+	/**
+	 * @brief Run the PPU for the given number of dots.
+	 * If the scanline renderer is enabled, visible scanlines that are run from their first to
+	 * their last dot are drawn in one go, and the idle dots of the post-render and VBlank
+	 * scanlines are skipped in bulk. Everything else runs dot by dot
+	 */
+	void Run(uint64_t dots);
+
+	inline void EnableScanlineRenderer(bool enable) { scanlineRenderer = enable; }
+	inline bool IsScanlineRendererEnabled() const { return scanlineRenderer; }
+
+	/**
+	 * @brief Only draw one out of every given number of frames.
+	 * Skipped frames don't produce any pixels, but still run everything else (sprite 0 hits,
+	 * sprite overflow, VBlank timing). 1 draws every frame
+	 */
+	inline void SetFrameSkip(uint32_t frames) { frameSkip = (frames == 0) ? 1 : frames; }
+	inline uint32_t GetFrameSkip() const { return frameSkip; }
+
+	/**
+	 * @brief Check whether the last finished frame was drawn to the screen.
+	 */
+	inline bool WasLastFrameDrawn() const { return lastFrameDrawn; }
+
+	/**
+	 * @brief Stop producing pixels, e.g. for frames that are run but never shown.
+	 * Works like a skipped frame, but takes effect immediately. Should only be changed between frames
+	 */
+	inline void SetOutputEnabled(bool enable) { outputEnabled = enable; }
+	inline bool IsOutputEnabled() const { return outputEnabled; }
+
 	/**
 	 * @brief Read from memory mapped PPU regs.
 	 */
@@ -128,6 +223,30 @@ public:
 	Byte ReadOAM(Byte offset);
 	void WriteOAM(Byte offset, Byte val);
 
+	/**
+	 * @brief Write a whole page to OAM, like 256 consecutive writes to OAMDATA would.
+	 */
+	void WriteOAMPage(const Byte* data);
+
+	/**
+	 * @brief Update the colors sent to the screen for every palette RAM entry.
+	 * Has to be called whenever palette RAM changes. Greyscale and emphasis bits are folded in
+	 */
+	void ResolvePalette();
+
+	/**
+	 * @brief Save the registers, the rendering pipeline and OAM.
+	 * Settings like the frame skip aren't part of the state, and neither is whether the
+	 * last frame was drawn, as that depends on the output setting
+	 */
+	void Serialize(SaveState& state) const;
+
+	/**
+	 * @brief Restore the registers, the rendering pipeline and OAM.
+	 * The palette RAM lives on the bus, so ResolvePalette() has to be called once it is restored
+	 */
+	void Deserialize(SaveState& state);
+
 	/**
 	 * @brief Check whether the PPU finished rendering a frame.
 	 * Returns true if the VBlankStart cycle was hit previously. The function resets
@@ -135,6 +254,17 @@ public:
 	 */
 	inline bool IsFrameDone() { bool returnVal = isFrameDone; isFrameDone = false; return returnVal; }
 
+	/**
+	 * @brief Number of dots that will be run before the dot that starts VBlank.
+	 */
+	uint32_t DotsUntilVBlank() const;
+
+	/**
+	 * @brief Number of dots after the current one that are on idle scanlines (post-render or VBlank).
+	 * The PPU doesn't touch OAM or OAMADDR during these dots
+	 */
+	uint32_t IdleDotsAhead() const;
+
 private:
 	/**
 	 * @brief Wraps Bus::ReadPPU.
@@ -146,14 +276,91 @@ private:
 	 */
 	void Write(Word addr, Byte val);
 
-	void UpdateState();
-	void EvaluateBackgroundTiles();
-	void EvaluateSprites();
+	/**
+	 * @brief Check whether the next dot starts a scanline the scanline renderer can draw.
+	 */
+	bool CanRenderScanline() const;
+
+	/**
+	 * @brief Run an entire visible scanline at once.
+	 * Leaves the PPU in the same state as ticking it through the scanline would
+	 */
+	void RenderScanline();
+
+	/**
+	 * @brief Skip over the idle dots (post-render and VBlank scanlines) following the current one.
+	 * Stops before the dot that sets the VBlank flag and before the pre-render scanline.
+	 * Returns the number of dots skipped, at most the given number
+	 */
+	uint64_t SkipIdleDots(uint64_t dots);
+
+	/**
+	 * @brief Decode the fetched bit planes of a sprite into its row of pixels.
+	 */
+	inline void DecodeSpriteRow(Byte slot)
+	{
+		TileCache::Unpack(TileCache::ExpandPlanes(sprites[slot].Lo, sprites[slot].Hi), spriteRows[slot].data());
+	}
+
+	/**
+	 * @brief Draw the fetched sprites into the sprite line buffer for the given range of dots.
+	 * Produces the same pixels GetSpritePixel() would for each of these dots
+	 */
+	void ComposeSprites(Word from, Word to);
+
+	/**
+	 * @brief Fetch the nametable, attribute and pattern bytes of the tile at the current VRAM address.
+	 */
+	void FetchBackgroundTile();
+
+	void EvaluateSecondaryOAM();
+
+	void IncrementCoarseX();
+	void IncrementFineY();
+	void CopyHorizontalScroll();
+	void CopyVerticalScroll();
+
+	inline Word NametableAddress() const { return 0x2000 | (current.Raw & 0x0FFF); }
+	inline Word AttributeAddress() const { return 0x23C0 | (current.Raw & 0x0C00) | ((current.Data.CoarseY >> 2) << 3) | (current.Data.CoarseX >> 2); }
+	inline Word BackgroundPatternAddress() const { return (((Word)ppuctrl.Flag.BackgrPatternTableAddr << 12) | ((Word)nametableByte << 4)) + current.Data.FineY; }
+	Byte AttributePalette() const;
+	Word SpritePatternAddress(Byte slot, bool highPlane) const;
 
 	Pixel GetBackgroundPixel();
 	Pixel GetSpritePixel();
 
-	Color MultiplexPixel(Pixel background, Pixel sprite);
+	Word MultiplexPixel(Pixel background, Pixel sprite);
+
+	/**
+	 * @brief Set the sprite 0 hit flag for a pixel where sprite 0 overlaps opaque background.
+	 */
+	void DetectSpriteZeroHit();
+
+	/**
+	 * @brief Check whether the current frame produces pixels.
+	 */
+	inline bool IsDrawing() const { return !skippingFrame && outputEnabled; }
+
+	static constexpr LineVariant GetLineVariant(Word line)
+	{
+		return
+			(line < 240) ? LineVariant::Visible :
+			(line == 240) ? LineVariant::PostRender :
+			(line == 241) ? LineVariant::VBlankStart :
+			(line < 261) ? LineVariant::VBlank :
+			LineVariant::PreRender;
+	}
+
+	/**
+	 * @brief Get the table entry of the current dot.
+	 * After a reset the PPU is outside of the frame until the next tick, this reports the first dot then
+	 */
+	inline const Dot& GetCurrentDot() const { return DotTables[(size_t)lineVariant][(x > 340) ? 0 : x]; }
+
+	/**
+	 * @brief Create the per-dot tables of all scanline variants.
+	 */
+	static constexpr std::array<DotTable, (size_t)LineVariant::Count> CreateDotTables();
 
 private: // Registers
 
@@ -230,20 +437,28 @@ private: // Registers
 	ShiftRegister hiAttribute{ 0 };
 	ShiftRegister loAttribute{ 0 };
 
-	std::vector<Byte> OAM;
-	std::vector<Byte> secondaryOAM;
-	std::vector<Sprite> sprites;
+	std::array<Byte, 64 * 4> OAM{};
+	std::array<Byte, 8 * 4> secondaryOAM{};
+	std::array<Sprite, 8> sprites{};
+	std::array<TileCache::Row, 8> spriteRows{};	//< Pixels of the fetched sprites, always matching their Lo and Hi planes
+	std::array<Pixel, 256> spriteLine;	//< Sprite pixels of the scanline drawn by the scanline renderer
+	std::array<Word, 0x20> resolvedPalette{};	//< Screen colors of the palette RAM entries (as seen from $3F00-$3F1F)
 	Byte OAMOverrideSignal = 0x00;
 	Byte freeSecondaryOAMSlot = 0x00;
 	Byte currentlyEvaluatedSprite = 0x00;
 
 private:
-	ScanlineType scanlineType;
-	CycleType cycleType;
-	FetchingPhase fetchPhase;
+	static const std::array<DotTable, (size_t)LineVariant::Count> DotTables;
 
-	uint8_t memoryAccessLatch = 0;
+	LineVariant lineVariant = LineVariant::Visible;
 	bool isFrameDone = false;
+	bool scanlineRenderer = true;
+
+	uint32_t frameSkip = 1;
+	uint32_t frameCounter = 0;
+	bool skippingFrame = false;
+	bool lastFrameDrawn = true;
+	bool outputEnabled = true;
 	Bus* bus;
-	Screen* screen;
+	FrameSink* screen;
 };
@@ -0,0 +1,232 @@
+#include "Rewinder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Bus.hpp"
+
+Rewinder::Rewinder(size_t budget) :
+	budget(budget)
+{
+	worker = std::thread(&Rewinder::Work, this);
+}
+
+Rewinder::~Rewinder()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+
+	wakeUp.notify_one();
+	worker.join();
+}
+
+void Rewinder::Push(Bus& bus)
+{
+	SaveState state;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!spare.empty())
+		{
+			state = std::move(spare.back());
+			spare.pop_back();
+		}
+	}
+
+	bus.Snapshot(state);
+
+	{
+		// Wait for the worker if it fell behind, so the snapshots waiting for it can't pile up
+		std::unique_lock<std::mutex> lock(mutex);
+		idle.wait(lock, [this] { return pending.size() < MaxPending; });
+		pending.push_back(std::move(state));
+	}
+
+	wakeUp.notify_one();
+}
+
+bool Rewinder::StepBack(Bus& bus)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		WaitUntilIdle(lock);
+
+		// The newest state is the current frame, the frame before it is redrawn from the state before that
+		if (deltas.size() < 2)
+			return false;
+
+		// Decode into a copy, the history must stay as it is if the machine rejects the state
+		older.GetData() = newest.GetData();
+		Decode(deltas[deltas.size() - 1], older.GetData());
+		Decode(deltas[deltas.size() - 2], older.GetData());
+		bus.Restore(older);
+
+		for (int i = 0; i < 2; i++)
+		{
+			usedMemory -= deltas.back().size();
+			deltas.pop_back();
+		}
+
+		std::swap(newest, older);
+	}
+
+	// The redrawn frame takes the place of the dropped state, so there is still one state per frame
+	bus.Frame();
+	Push(bus);
+	return true;
+}
+
+void Rewinder::Clear()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	WaitUntilIdle(lock);
+
+	deltas.clear();
+	hasNewest = false;
+	usedMemory = 0;
+}
+
+size_t Rewinder::GetStateCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return deltas.size();
+}
+
+size_t Rewinder::GetMemoryUsage()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return usedMemory + SnapshotMemory();
+}
+
+void Rewinder::Work()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		wakeUp.wait(lock, [this] { return stop || !pending.empty(); });
+		if (stop)
+			return;
+
+		SaveState state = std::move(pending.front());
+		pending.pop_front();
+		busy = true;
+
+		// Nobody else touches the newest state while the worker is busy
+		lock.unlock();
+		if (hasNewest)
+			Encode(state.GetData(), newest.GetData(), scratch);
+		lock.lock();
+
+		if (hasNewest)
+		{
+			deltas.emplace_back(scratch.begin(), scratch.end());
+			usedMemory += scratch.size();
+		}
+
+		std::swap(newest, state);
+		hasNewest = true;
+		spare.push_back(std::move(state));
+
+		while (usedMemory + SnapshotMemory() > budget && !deltas.empty())
+		{
+			usedMemory -= deltas.front().size();
+			deltas.pop_front();
+		}
+
+		busy = false;
+		idle.notify_all();
+	}
+}
+
+size_t Rewinder::SnapshotMemory() const
+{
+	size_t memory = newest.GetData().capacity() + older.GetData().capacity();
+	for (const SaveState& state : pending)
+		memory += state.GetData().capacity();
+	for (const SaveState& state : spare)
+		memory += state.GetData().capacity();
+
+	return memory;
+}
+
+void Rewinder::WaitUntilIdle(std::unique_lock<std::mutex>& lock)
+{
+	idle.wait(lock, [this] { return pending.empty() && !busy; });
+}
+
+void Rewinder::Encode(const std::vector<Byte>& newer, const std::vector<Byte>& older, std::vector<Byte>& delta)
+{
+	// States only differ in size if the number of scheduled events differs, missing bytes count as 0
+	size_t size = std::max(newer.size(), older.size());
+	auto difference = [&](size_t i) -> Byte
+	{
+		return (i < newer.size() ? newer[i] : 0) ^ (i < older.size() ? older[i] : 0);
+	};
+
+	auto append = [&](const void* data, size_t length)
+	{
+		delta.insert(delta.end(), (const Byte*)data, (const Byte*)data + length);
+	};
+
+	delta.clear();
+	uint32_t olderSize = (uint32_t)older.size();
+	append(&olderSize, sizeof(olderSize));
+
+	// Tokens of <zero run length> <literal length> <literals>. Short zero runs
+	// are kept in the literals, a token costs more than they do
+	size_t i = 0;
+	while (i < size)
+	{
+		uint16_t zeros = 0;
+		while (i < size && zeros < MaxRunLength && difference(i) == 0)
+		{
+			zeros++;
+			i++;
+		}
+
+		size_t start = i;
+		uint16_t literals = 0;
+		while (i < size && literals < MaxRunLength)
+		{
+			size_t end = std::min(i + 4, size);
+			bool zeroRun = (end - i == 4);
+			for (size_t j = i; j < end && zeroRun; j++)
+				zeroRun = (difference(j) == 0);
+
+			if (zeroRun)
+				break;
+
+			literals++;
+			i++;
+		}
+
+		append(&zeros, sizeof(zeros));
+		append(&literals, sizeof(literals));
+		for (size_t j = start; j < start + literals; j++)
+			delta.push_back(difference(j));
+	}
+}
+
+void Rewinder::Decode(const std::vector<Byte>& delta, std::vector<Byte>& state)
+{
+	uint32_t olderSize;
+	memcpy(&olderSize, delta.data(), sizeof(olderSize));
+	state.resize(std::max<size_t>(state.size(), olderSize), 0);
+
+	size_t position = sizeof(olderSize);
+	size_t i = 0;
+	while (position < delta.size())
+	{
+		uint16_t zeros, literals;
+		memcpy(&zeros, delta.data() + position, sizeof(zeros));
+		memcpy(&literals, delta.data() + position + sizeof(zeros), sizeof(literals));
+		position += sizeof(zeros) + sizeof(literals);
+
+		i += zeros;
+		for (uint16_t j = 0; j < literals; j++)
+			state[i++] ^= delta[position++];
+	}
+
+	state.resize(olderSize);
+}
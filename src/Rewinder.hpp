@@ -0,0 +1,114 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Types.hpp"
+#include "SaveState.hpp"
+
+class Bus;
+
+/**
+ * @brief Keeps the machine states of past frames, so the emulation can be run backwards.
+ *
+ * Only the newest state is stored as a whole. Every older state is stored as the XOR
+ * difference to the state after it, which is mostly zeros and gets its zero runs
+ * run-length encoded. Since no state depends on an older one, the oldest states can
+ * simply be dropped to stay within the memory budget.
+ *
+ * Encoding happens on a worker thread, Push() only takes the snapshot and hands it over.
+ * Push() waits if the worker is too far behind, so only a few snapshots can be queued.
+ */
+class Rewinder
+{
+public:
+	/**
+	 * @brief The budget is the number of bytes the states may take up.
+	 * This includes the full snapshots kept besides the encoded states
+	 */
+	Rewinder(size_t budget);
+	~Rewinder();
+
+	/**
+	 * @brief Save the current state of the machine, usually after every frame.
+	 */
+	void Push(Bus& bus);
+
+	/**
+	 * @brief Go back to the state before the newest one and redraw its frame.
+	 * The frame buffer isn't saved, so this restores the state before the wanted one and
+	 * runs one frame, which is saved as the newest state again. Returns false (and leaves
+	 * the machine alone) if there aren't enough older states
+	 */
+	bool StepBack(Bus& bus);
+
+	/**
+	 * @brief Drop all saved states.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Number of states that can be stepped back to.
+	 */
+	size_t GetStateCount();
+
+	/**
+	 * @brief Number of bytes taken up by the encoded states and the full snapshots.
+	 */
+	size_t GetMemoryUsage();
+
+private:
+	/**
+	 * @brief Encode the given states into the worker's delta list.
+	 */
+	void Work();
+
+	/**
+	 * @brief Wait until the worker has encoded every state handed to it.
+	 * The lock has to be held, the worker doesn't start anything new until it is released
+	 */
+	void WaitUntilIdle(std::unique_lock<std::mutex>& lock);
+
+	/**
+	 * @brief Number of bytes taken up by full snapshots (the newest, queued and spare ones).
+	 * The lock has to be held
+	 */
+	size_t SnapshotMemory() const;
+
+	/**
+	 * @brief Encode the difference between two states.
+	 * Runs of zero bytes in the XOR difference are stored as their length, everything else as is
+	 */
+	static void Encode(const std::vector<Byte>& newer, const std::vector<Byte>& older, std::vector<Byte>& delta);
+
+	/**
+	 * @brief Turn the newer state back into the older one.
+	 */
+	static void Decode(const std::vector<Byte>& delta, std::vector<Byte>& state);
+
+private:
+	static constexpr size_t MaxRunLength = 0xFFFF;	//< Runs are stored as 16 bit lengths
+	static constexpr size_t MaxPending = 4;			//< Snapshots that may wait for the worker
+
+	size_t budget;
+	size_t usedMemory = 0;
+
+	SaveState newest;
+	SaveState older;	//< Decoding buffer of StepBack()
+	bool hasNewest = false;
+	std::deque<std::vector<Byte>> deltas;	//< Oldest first
+	std::vector<Byte> scratch;				//< Encoding buffer of the worker
+
+	std::deque<SaveState> pending;	//< Snapshots waiting to be encoded
+	std::vector<SaveState> spare;	//< Snapshot buffers that can be reused
+
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::condition_variable idle;	//< Notified after every encoded state
+	bool busy = false;
+	bool stop = false;
+
+	std::thread worker;
+};
@@ -0,0 +1,30 @@
+#include "RunAhead.hpp"
+
+#include "Bus.hpp"
+
+RunAhead::RunAhead(Bus* bus, uint32_t frames) :
+	bus(bus), frames(frames)
+{
+}
+
+void RunAhead::Frame()
+{
+	if (frames == 0)
+	{
+		bus->Frame();
+		return;
+	}
+
+	// The real frame, it is only shown once the frames ahead have been run
+	bus->SetOutputEnabled(false);
+	bus->Frame();
+	bus->Snapshot(state);
+
+	for (uint32_t i = 1; i < frames; i++)
+		bus->Frame();
+
+	bus->SetOutputEnabled(true);
+	bus->Frame();
+
+	bus->Restore(state);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Types.hpp"
+#include "SaveState.hpp"
+
+class Bus;
+
+/**
+ * @brief Hides input lag by showing frames from the future.
+ *
+ * Every host frame first runs the real next frame without drawing it and saves the
+ * machine. It then runs the given number of frames ahead, only drawing the last one,
+ * and restores the saved state. The screen therefore shows the reaction to the current
+ * input as many frames earlier as the game lags behind it.
+ */
+class RunAhead
+{
+public:
+	RunAhead(Bus* bus, uint32_t frames = 1);
+
+	/**
+	 * @brief Number of frames to run ahead, 0 turns run-ahead off.
+	 */
+	inline void SetFrames(uint32_t count) { frames = count; }
+	inline uint32_t GetFrames() const { return frames; }
+
+	/**
+	 * @brief Advance the emulation by one frame and draw the frame that many frames ahead.
+	 */
+	void Frame();
+
+private:
+	Bus* bus;
+	uint32_t frames;
+	SaveState state;	//< Reused every frame, so snapshots don't allocate
+};
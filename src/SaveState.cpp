@@ -0,0 +1,29 @@
+#include "SaveState.hpp"
+
+#include <fstream>
+
+void SaveState::SaveToFile(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("Failed to open file " + path);
+
+	file.write((const char*)data.data(), data.size());
+	if (!file)
+		throw std::runtime_error("Failed to write save state to " + path);
+}
+
+void SaveState::LoadFromFile(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		throw std::runtime_error("Failed to open file " + path);
+
+	data.resize((size_t)file.tellg());
+	file.seekg(0);
+	file.read((char*)data.data(), data.size());
+	readPosition = 0;
+
+	if (!file)
+		throw std::runtime_error("Failed to read save state from " + path);
+}
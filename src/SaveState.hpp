@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include "Types.hpp"
+
+/**
+ * @brief A snapshot of the whole machine as a flat byte buffer.
+ *
+ * Every component appends its state with Write() and reads it back in the same order
+ * with Read(), so a snapshot is a sequence of plain memory copies. Bools and enums are
+ * range checked when they are read back.
+ *
+ * Values are stored in the host's byte order, so save state files can only be exchanged
+ * between hosts of the same endianness (all supported platforms are little-endian). A
+ * state from a host of the other endianness is rejected, because its magic is reversed.
+ * The buffer keeps its memory when it is cleared, so a state that is saved over and
+ * over again (e.g. for rewinding) doesn't allocate.
+ *
+ * Layout: magic, version, then the sections written by Bus::Snapshot()
+ */
+class SaveState
+{
+public:
+	static constexpr uint32_t Magic = 0x5353454E;	//< "NESS"
+	static constexpr uint32_t Version = 2;
+
+public:
+	/**
+	 * @brief Drop the contents and start writing from the beginning.
+	 */
+	inline void Clear() { data.clear(); readPosition = 0; }
+
+	/**
+	 * @brief Start reading from the beginning.
+	 */
+	inline void Rewind() { readPosition = 0; }
+
+	template<typename T>
+	inline void Write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be written to a save state");
+		WriteBytes(&value, sizeof(T));
+	}
+
+	template<typename T>
+	inline void Read(T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be read from a save state");
+		ReadBytes(&value, sizeof(T));
+	}
+
+	/**
+	 * @brief Read a bool, bytes other than 0 and 1 are rejected.
+	 */
+	inline void Read(bool& value)
+	{
+		Byte raw;
+		ReadBytes(&raw, 1);
+		if (raw > 1)
+			throw std::runtime_error("Save state contains an invalid flag");
+
+		value = (raw != 0);
+	}
+
+	/**
+	 * @brief Read an enum, values after the given last one are rejected.
+	 */
+	template<typename T>
+	inline void ReadEnum(T& value, T last)
+	{
+		static_assert(std::is_enum<T>::value, "Only enums can be range checked");
+
+		std::underlying_type_t<T> raw;
+		ReadBytes(&raw, sizeof(raw));
+		if (raw > (std::underlying_type_t<T>)last)
+			throw std::runtime_error("Save state contains an invalid enum value");
+
+		value = (T)raw;
+	}
+
+	inline void WriteBytes(const void* source, size_t size)
+	{
+		size_t offset = data.size();
+		data.resize(offset + size);
+		memcpy(data.data() + offset, source, size);
+	}
+
+	inline void ReadBytes(void* target, size_t size)
+	{
+		if (readPosition + size > data.size())
+			throw std::runtime_error("Save state is truncated");
+
+		memcpy(target, data.data() + readPosition, size);
+		readPosition += size;
+	}
+
+	inline size_t GetSize() const { return data.size(); }
+	inline bool IsAtEnd() const { return readPosition == data.size(); }
+
+	/**
+	 * @brief Direct access to the bytes, e.g. to compress them.
+	 */
+	inline std::vector<Byte>& GetData() { return data; }
+	inline const std::vector<Byte>& GetData() const { return data; }
+
+	/**
+	 * @brief Write the state to disk.
+	 */
+	void SaveToFile(const std::string& path) const;
+
+	/**
+	 * @brief Replace the state with one from disk.
+	 */
+	void LoadFromFile(const std::string& path);
+
+private:
+	std::vector<Byte> data;
+	size_t readPosition = 0;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include "Types.hpp"
+#include "SaveState.hpp"
+
+/**
+ * @brief Keeps track of upcoming events on the master clock.
+ * Timestamps are measured in master clock ticks, which are PPU dots. One CPU
+ * cycle takes 3 ticks. Everything between two events is run in one slice
+ */
+class Scheduler
+{
+public:
+	enum class Event : Byte
+	{
+		VBlank,	//< The PPU started VBlank (and might have sent an NMI)
+		CPU,	//< The CPU starts its next instruction
+		DMA		//< One cycle of OAM DMA, the CPU is suspended meanwhile
+	};
+
+	struct ScheduledEvent
+	{
+		uint64_t Timestamp;
+		Event Type;
+
+		inline bool operator>(const ScheduledEvent& other) const
+		{
+			return (Timestamp != other.Timestamp) ? (Timestamp > other.Timestamp) : (Type > other.Type);
+		}
+	};
+
+public:
+	/**
+	 * @brief Add an event at the given timestamp.
+	 */
+	inline void Schedule(Event type, uint64_t timestamp)
+	{
+		events.push_back({ timestamp, type });
+		std::push_heap(events.begin(), events.end(), std::greater<ScheduledEvent>());
+	}
+
+	/**
+	 * @brief Timestamp of the next event, or UINT64_MAX if there is none.
+	 */
+	inline uint64_t NextTimestamp() const { return events.empty() ? UINT64_MAX : events.front().Timestamp; }
+
+	/**
+	 * @brief Remove the next event and return it.
+	 */
+	inline ScheduledEvent Pop()
+	{
+		std::pop_heap(events.begin(), events.end(), std::greater<ScheduledEvent>());
+		ScheduledEvent event = events.back();
+		events.pop_back();
+		return event;
+	}
+
+	/**
+	 * @brief Drop all pending events.
+	 */
+	inline void Clear() { events.clear(); }
+
+	/**
+	 * @brief Save the pending events.
+	 */
+	inline void Serialize(SaveState& state) const
+	{
+		state.Write((uint32_t)events.size());
+		for (const ScheduledEvent& event : events)
+		{
+			state.Write(event.Timestamp);
+			state.Write(event.Type);
+		}
+	}
+
+	/**
+	 * @brief Replace the pending events with saved ones.
+	 */
+	inline void Deserialize(SaveState& state)
+	{
+		uint32_t count;
+		state.Read(count);
+		if (count > MaxEvents)
+			throw std::runtime_error("Save state contains too many events");
+
+		events.resize(count);
+		for (ScheduledEvent& event : events)
+		{
+			state.Read(event.Timestamp);
+			state.ReadEnum(event.Type, Event::DMA);
+		}
+	}
+
+private:
+	static constexpr uint32_t MaxEvents = 16;	//< There is never more than one event of each type
+
+	std::vector<ScheduledEvent> events;	//< Min-heap, the next event is in front
+};
@@ -0,0 +1,65 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (size_t i = 0; i < threads; i++)
+		workers.emplace_back(&ThreadPool::Work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	Wait();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+
+	wakeUp.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+
+	wakeUp.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return jobs.empty() && runningJobs == 0; });
+}
+
+void ThreadPool::Work()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		wakeUp.wait(lock, [this] { return stop || !jobs.empty(); });
+		if (jobs.empty())
+			return;
+
+		std::function<void()> job = std::move(jobs.front());
+		jobs.pop_front();
+		runningJobs++;
+
+		lock.unlock();
+		job();
+		lock.lock();
+
+		runningJobs--;
+		if (jobs.empty() && runningJobs == 0)
+			done.notify_all();
+	}
+}
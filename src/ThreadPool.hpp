@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+
+/**
+ * @brief A fixed set of worker threads that run submitted jobs.
+ *
+ * Emulator instances don't share any state, so every instance can be run as its own
+ * job. Jobs are started in the order they were submitted.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * @brief Start the given number of workers, 0 starts one per hardware thread.
+	 */
+	ThreadPool(size_t threads = 0);
+
+	/**
+	 * @brief Finish all submitted jobs and stop the workers.
+	 */
+	~ThreadPool();
+
+	/**
+	 * @brief Queue a job, jobs must not throw.
+	 */
+	void Submit(std::function<void()> job);
+
+	/**
+	 * @brief Block until every submitted job has finished.
+	 */
+	void Wait();
+
+	inline size_t GetThreadCount() const { return workers.size(); }
+
+private:
+	void Work();
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	size_t runningJobs = 0;
+
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::condition_variable done;
+	bool stop = false;
+};
@@ -0,0 +1,23 @@
+#include "TileCache.hpp"
+
+void TileCache::Reset(const std::vector<Byte>& memory)
+{
+	chr = &memory;
+	rows = std::vector<Row>(chr->size() / 2);
+	valid = std::vector<bool>(chr->size() / 16, false);
+}
+
+void TileCache::Decode(size_t tile)
+{
+	misses++;
+
+	for (size_t y = 0; y < 8; y++)
+	{
+		Byte lo = (*chr)[(tile << 4) + y];
+		Byte hi = (*chr)[(tile << 4) + 8 + y];
+
+		Unpack(ExpandPlanes(lo, hi), rows[(tile << 3) | y].data());
+	}
+
+	valid[tile] = true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <array>
+#include "Types.hpp"
+
+/**
+ * @brief Pre-decoded tiles of a cartridge's CHR memory.
+ *
+ * Every row of an 8x8 tile is stored as 8 pixel indices (0-3), so the renderer doesn't
+ * have to combine the two bit planes itself. Tiles are keyed by their offset into CHR
+ * memory, which makes them independent of the currently mapped CHR banks. They are
+ * decoded the first time they are used, and have to be invalidated when the CHR
+ * memory behind them is written to.
+ */
+class TileCache
+{
+public:
+	using Row = std::array<Byte, 8>;
+
+public:
+	/**
+	 * @brief Use the given CHR memory and drop all decoded tiles.
+	 * Has to be called after the CHR memory was (re)allocated. Copies of the cache keep
+	 * using the same memory
+	 */
+	void Reset(const std::vector<Byte>& memory);
+
+	/**
+	 * @brief Get a decoded tile row.
+	 * The offset is the offset of the row's low bit plane into CHR memory
+	 */
+	inline const Row& GetRow(size_t offset)
+	{
+		size_t tile = offset >> 4;
+		if (valid[tile])
+			hits++;
+		else
+			Decode(tile);
+
+		return rows[(tile << 3) | (offset & 0x7)];
+	}
+
+	/**
+	 * @brief Mark the tile containing the given offset as outdated.
+	 */
+	inline void Invalidate(size_t offset) { valid[offset >> 4] = false; }
+
+	/**
+	 * @brief Expand the two bit planes of a tile row into its 8 pixel indices.
+	 * The pixels are packed into one integer with the leftmost pixel in the lowest byte,
+	 * so whole rows can be combined with plain integer operations (see Pack()/Unpack())
+	 */
+	static inline uint64_t ExpandPlanes(Byte lo, Byte hi) { return SpreadBits(lo) | (SpreadBits(hi) << 1); }
+
+	/**
+	 * @brief Pack a decoded row the same way ExpandPlanes() does.
+	 */
+	static inline uint64_t Pack(const Row& row)
+	{
+		uint64_t pixels = 0;
+		for (int i = 0; i < 8; i++)
+			pixels |= (uint64_t)row[i] << (8 * i);
+
+		return pixels;
+	}
+
+	/**
+	 * @brief Write the 8 pixels of a packed row to memory, leftmost pixel first.
+	 */
+	static inline void Unpack(uint64_t pixels, Byte* target)
+	{
+		for (int i = 0; i < 8; i++)
+			target[i] = (Byte)(pixels >> (8 * i));
+	}
+
+	inline uint64_t GetHits() const { return hits; }
+	inline uint64_t GetMisses() const { return misses; }
+
+private:
+	void Decode(size_t tile);
+
+	/**
+	 * @brief Move bit 7-i of the given byte to bit 0 of byte i.
+	 */
+	static inline uint64_t SpreadBits(Byte bits)
+	{
+		// Copy the byte into every byte, keep a different bit in each of them and then
+		// turn every non-zero byte into a 1 (adding 0x7F never carries into the next byte)
+		uint64_t spread = (bits * 0x0101010101010101ull) & 0x0102040810204080ull;
+		return ((spread + 0x7F7F7F7F7F7F7F7Full) >> 7) & 0x0101010101010101ull;
+	}
+
+private:
+	const std::vector<Byte>* chr = nullptr;
+	std::vector<Row> rows;
+	std::vector<bool> valid;
+
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+};
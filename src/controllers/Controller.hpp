@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Types.hpp"
+#include "../SaveState.hpp"
 
 union PortLatch
 {
@@ -22,7 +23,15 @@ public:
 	Controller(Byte outPin) : outPin(outPin) {}
 	virtual ~Controller() {}
 
-	virtual void OUT(PortLatch latch) = 0;
+	/**
+	 * @brief Create an identical controller for a cloned machine.
+	 */
+	virtual Controller* Clone() const = 0;
+
+	/**
+	 * @brief Load the given buttons into the shift register (called while the strobe bit is set).
+	 */
+	virtual void Reload(Byte buttons) = 0;
 
 	inline Byte CLK()
 	{
@@ -32,6 +41,12 @@ public:
 		return 0x40 | (output << outPin);
 	}
 
+	/**
+	 * @brief Save the shift register, controllers with more state have to extend this.
+	 */
+	virtual void Serialize(SaveState& state) const { state.Write(outRegister); }
+	virtual void Deserialize(SaveState& state) { state.Read(outRegister); }
+
 protected:
 	Byte outPin;
 	Byte outRegister{0};
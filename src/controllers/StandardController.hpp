@@ -25,7 +25,8 @@ class StandardController :
 public:
 	StandardController();
 
-	virtual void OUT(PortLatch latch);
+	virtual Controller* Clone() const override;
+	virtual void Reload(Byte buttons) override;
 
 private:
 };
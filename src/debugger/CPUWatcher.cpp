@@ -19,6 +19,7 @@ void CPUWatcher::OnRender()
 		return;
 	}
 
+	StatusFlag status = cpu->GetStatus();
 	if (ImGui::CollapsingHeader("Registers", ImGuiTreeNodeFlags_DefaultOpen))
 	{
 
@@ -27,7 +28,7 @@ void CPUWatcher::OnRender()
 		ImGui::InputScalar("Y", ImGuiDataType_U8, &cpu->idy, (const void*)0, (const void*)0, "%02X", ImGuiInputTextFlags_CharsHexadecimal);
 		ImGui::InputScalar("PC", ImGuiDataType_U16, &cpu->pc, (const void*)0, (const void*)0, "%04X", ImGuiInputTextFlags_CharsHexadecimal);
 		ImGui::InputScalar("SP", ImGuiDataType_U8, &cpu->sp, (const void*)0, (const void*)0, "%02X", ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_ReadOnly);
-		ImGui::InputScalar("P", ImGuiDataType_U8, &cpu->status.Raw, (const void*)0, (const void*)0, "%02X", ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_ReadOnly);
+		ImGui::InputScalar("P", ImGuiDataType_U8, &status.Raw, (const void*)0, (const void*)0, "%02X", ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_ReadOnly);
 	}
 
 	ImGui::Separator();
@@ -53,21 +54,21 @@ void CPUWatcher::OnRender()
 
 
 		ImGui::TableNextColumn();
-		ImGui::Text(cpu->status.Flag.Negative ? "1" : "-");
+		ImGui::Text(status.Flag.Negative ? "1" : "-");
 		ImGui::TableNextColumn();
-		ImGui::Text(cpu->status.Flag.Overflow ? "1" : "-");
+		ImGui::Text(status.Flag.Overflow ? "1" : "-");
 		ImGui::TableNextColumn();
-		ImGui::Text(cpu->status.Flag.NoEffect ? "1" : "-");
+		ImGui::Text(status.Flag.NoEffect ? "1" : "-");
 		ImGui::TableNextColumn();
-		ImGui::Text(cpu->status.Flag.Break ? "1" : "-");
+		ImGui::Text(status.Flag.Break ? "1" : "-");
 		ImGui::TableNextColumn();
-		ImGui::Text(cpu->status.Flag.Decimal ? "1" : "-");
+		ImGui::Text(status.Flag.Decimal ? "1" : "-");
 		ImGui::TableNextColumn();
-		ImGui::Text(cpu->status.Flag.InterruptDisable ? "1" : "-");
+		ImGui::Text(status.Flag.InterruptDisable ? "1" : "-");
 		ImGui::TableNextColumn();
-		ImGui::Text(cpu->status.Flag.Zero ? "1" : "-");
+		ImGui::Text(status.Flag.Zero ? "1" : "-");
 		ImGui::TableNextColumn();
-		ImGui::Text(cpu->status.Flag.Carry ? "1" : "-");
+		ImGui::Text(status.Flag.Carry ? "1" : "-");
 		ImGui::TableNextColumn();
 
 		ImGui::EndTable();
@@ -77,5 +78,16 @@ void CPUWatcher::OnRender()
 
 	ImGui::Text("Halted: %s", cpu->halted ? "Yes" : "No");
 
+	if (ImGui::CollapsingHeader("Decode Cache"))
+	{
+		uint64_t hits = cpu->GetDecodeCacheHits();
+		uint64_t misses = cpu->GetDecodeCacheMisses();
+		uint64_t total = hits + misses;
+
+		ImGui::Text("Hits:     %llu", (unsigned long long)hits);
+		ImGui::Text("Misses:   %llu", (unsigned long long)misses);
+		ImGui::Text("Hit rate: %.2f%%", total ? 100.0 * hits / total : 0.0);
+	}
+
 	ImGui::End();
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 #include "../Bus.hpp"
 #include "../Log.hpp"
+#include "../Rewinder.hpp"
+#include "../RunAhead.hpp"
 #include "CPUWatcher.hpp"
 #include "PPUWatcher.hpp"
 #include "Disassembler.hpp"
@@ -19,6 +21,9 @@
 Debugger::Debugger(Bus* bus) :
 	bus(bus)
 {
+	rewinder = new Rewinder(RewindBudget);
+	runAhead = new RunAhead(bus, 0);
+
 	windows.push_back(new CPUWatcher(this, &bus->cpu));
 
 	ppuWatcher = new PPUWatcher(this, &bus->ppu);
@@ -34,19 +39,22 @@ Debugger::Debugger(Bus* bus) :
 	windows.push_back(new ControllerPortViewer(this, &bus->controllerPort));
 	windows.push_back(new Palettes(this, bus));
 
-	Logger::Init(this);
-	windows.push_back(Logger::GetInstance());	
+	logger = new Logger(this);
+	windows.push_back(logger);
 }
 
 Debugger::~Debugger()
 {
 	for (DebugWindow* window : windows)
 		delete window;
+
+	delete runAhead;
+	delete rewinder;
 }
 
 bool Debugger::Frame()
 {
-	Logger::GetInstance()->Log("Debugger", "Frame!\n");
+	logger->Log("Debugger", "Frame!\n");
 	try
 	{
 		while (!bus->ppu.IsFrameDone())
@@ -71,10 +79,28 @@ bool Debugger::Frame()
 
 bool Debugger::Update()
 {
-	if (running)
-		return Frame();
+	// Let single steps see every OAM DMA transfer
+	bus->EnableBulkDMA(running);
 
-	return true;
+	if (!running)
+		return true;
+
+	// Stepping back redraws the screen and saves the redrawn frame itself
+	if (rewinding)
+	{
+		rewinder->StepBack(*bus);
+		return true;
+	}
+
+	// Breakpoints are only checked without run-ahead, they would hit in frames that are thrown away
+	bool result = true;
+	if (runAhead->GetFrames() > 0)
+		runAhead->Frame();
+	else
+		result = Frame();
+
+	rewinder->Push(*bus);
+	return result;
 }
 
 void Debugger::Render()
@@ -131,6 +157,12 @@ void Debugger::Render()
 		if (ImGui::Button(running ? "Pause" : "Run"))
 			running = !running;
 
+		ImGui::SameLine();
+
+		// Rewinds for as long as the button is held
+		ImGui::Button("Rewind");
+		rewinding = ImGui::IsItemActive();
+
 		ImGui::PushItemFlag(ImGuiItemFlags_Disabled, running);
 		if (running)
 			ImGui::PushStyleColor(ImGuiCol_Button, ImVec4{ 0.7f, 0.7f, 0.7f, 0.7f });
@@ -164,11 +196,17 @@ void Debugger::Render()
 			overrideResetVector = !overrideResetVector;
 
 		ImGui::InputScalar("Reset Vector", ImGuiDataType_U16, &resetVector, (const void*)0, (const void*)0, "%04X", ImGuiInputTextFlags_CharsHexadecimal);
+
+		ImGui::Separator();
+
+		if (ImGui::SliderInt("Run-ahead Frames", &runAheadFrames, 0, 4))
+			runAhead->SetFrames((uint32_t)runAheadFrames);
 	}
 
 	ImGui::Separator();
 
 	ImGui::Text("FPS: %f", ImGui::GetIO().Framerate);
+	ImGui::Text("Rewind buffer: %zu frames (%.1f MB)", rewinder->GetStateCount(), rewinder->GetMemoryUsage() / (1024.0 * 1024.0));
 
 	for (DebugWindow* window : windows)
 	{
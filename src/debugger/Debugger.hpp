@@ -6,6 +6,9 @@
 class Bus;
 class Disassembler;
 class PPUWatcher;
+class Logger;
+class Rewinder;
+class RunAhead;
 
 class Debugger
 {
@@ -21,12 +24,19 @@ public:
 	bool isOpen = true;
 
 private:
+	static constexpr size_t RewindBudget = 64 * 1024 * 1024;	//< About 10 minutes of states
+
 	Bus* bus;
 	bool running = false;
+	bool rewinding = false;	//< The rewind button is held down
+	int runAheadFrames = 0;
 	bool overrideResetVector = false;
 	uint16_t resetVector = 0x0000;
 
+	Rewinder* rewinder;
+	RunAhead* runAhead;
 	std::vector<DebugWindow*> windows;
 	Disassembler* disassembler;
 	PPUWatcher* ppuWatcher;
+	Logger* logger;
 };
@@ -96,7 +96,7 @@ bool Disassembler::BreakpointHit()
 
 void Disassembler::Disassemble(std::string& target, uint16_t& pc)
 {
-	Instruction* currentInstr = &cpu->InstructionTable[cpu->Read(pc)];
+	const Instruction* currentInstr = &cpu->InstructionTable[cpu->Read(pc)];
 	Disassemble(target, pc, currentInstr);
 	pc += currentInstr->Size;
 }
@@ -11,15 +11,6 @@ Logger::Logger(Debugger* debugger) :
     offsets.push_back(0);
 }
 
-void Logger::Init(Debugger* debugger) 
-{
-    if (Logger::instance != nullptr) {
-        return;
-    }
-
-    Logger::instance = new Logger(debugger);
-}
-
 void Logger::Log(const char* module, const char* fmt, ...) 
 {
     int old_size = buffer.size();
@@ -8,7 +8,7 @@ NametableViewer::NametableViewer(Debugger* debugger, Bus* bus) :
 	DebugWindow("Nametable Viewer", debugger), bus(bus), texture(0), attributeTexture(0)
 {
 	glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-	glTextureStorage2D(texture, 1, GL_R8, 32, 32);
+	glTextureStorage2D(texture, 1, GL_R8, 256, 240);
 
 	glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -60,7 +60,7 @@ void NametableViewer::OnRender()
 
 			if (renderNametable)
 			{
-				glTextureSubImage2D(texture, 0, 0, 0, 32, 32, GL_RED, GL_UNSIGNED_BYTE, &bus->VRAM[0x400 * index]);
+				RenderNametable(index);
 			}
 
 			if (renderAttributeTable)
@@ -154,6 +154,27 @@ void NametableViewer::DisplayNametable(uint8_t index)
 	}
 }
 
+void NametableViewer::RenderNametable(uint8_t index)
+{
+	Word baseAddr = 0x400 * index;
+	Word patternTable = (Word)bus->ppu.ppuctrl.Flag.BackgrPatternTableAddr << 12;
+	std::vector<uint8_t> pixels(256 * 240);
+
+	for (int tile = 0; tile < 32 * 30; tile++)
+	{
+		Byte entry = bus->VRAM[baseAddr + tile];
+
+		for (int y = 0; y < 8; y++)
+		{
+			const TileCache::Row& row = bus->ReadTileRow(patternTable | (entry << 4) | y);
+			for (int x = 0; x < 8; x++)
+				pixels[(8 * (tile / 32) + y) * 256 + 8 * (tile % 32) + x] = row[x] * 80;
+		}
+	}
+
+	glTextureSubImage2D(texture, 0, 0, 0, 256, 240, GL_RED, GL_UNSIGNED_BYTE, (const void*)pixels.data());
+}
+
 void NametableViewer::RenderAttributeTable(uint8_t index)
 {
 	Word baseAddr = 0x400 * index + 0x3C0;
@@ -15,6 +15,7 @@ public:
 	
 private:
 	void DisplayNametable(uint8_t index);
+	void RenderNametable(uint8_t index);
 	void RenderAttributeTable(uint8_t index);
 
 private:
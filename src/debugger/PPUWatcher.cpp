@@ -45,9 +45,14 @@ void PPUWatcher::OnRender()
 	}
 
 	ImGui::Text("On Pixel (%d, %d)", ppu->x, ppu->y);
-	ImGui::Text("Scanline      : %s", scanlineTypeNames.find(ppu->scanlineType)->second.c_str());
-	ImGui::Text("Cycle         : %s", cycleTypeNames.find(ppu->cycleType)->second.c_str());
-	ImGui::Text("Fetching Phase: %s", fetchingPhaseNames.find(ppu->fetchPhase)->second.c_str());
+	const PPU::Dot& dot = ppu->GetCurrentDot();
+	ImGui::Text("Scanline      : %s", scanlineTypeNames.find(dot.Scanline)->second.c_str());
+	ImGui::Text("Cycle         : %s", cycleTypeNames.find(dot.Cycle)->second.c_str());
+	ImGui::Text("Fetching Phase: %s", fetchingPhaseNames.find(dot.Phase)->second.c_str());
+
+	bool scanlineRenderer = ppu->IsScanlineRendererEnabled();
+	if (ImGui::Checkbox("Scanline renderer", &scanlineRenderer))
+		ppu->EnableScanlineRenderer(scanlineRenderer);
 
 	ImGui::Separator();
 
@@ -254,7 +259,7 @@ bool PPUWatcher::BreakpointHit()
 
 	for (const FrameStateBreakpoint& breakpoint : breakpoints)
 	{
-		if (breakpoint.enabled && breakpoint.location == ppu->scanlineType)
+		if (breakpoint.enabled && breakpoint.location == ppu->GetCurrentDot().Scanline)
 			return true;
 	}
 
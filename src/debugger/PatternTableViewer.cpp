@@ -2,7 +2,7 @@
 
 #include <glad/glad.h>
 #include <imgui/imgui.h>
-#include "Mapper000.hpp"
+#include "../Mapper.hpp"
 
 PatternTableViewer::PatternTableViewer(Debugger* debugger, Mapper* mapper) :
 	DebugWindow("Pattern Table Viewer", debugger), mapper(mapper)
@@ -54,7 +54,11 @@ void PatternTableViewer::OnRender()
 
 		ImGui::EndTabBar();
 	}
-	
+
+	const TileCache& tileCache = mapper->GetTileCache();
+	uint64_t hits = tileCache.GetHits();
+	uint64_t total = hits + tileCache.GetMisses();
+	ImGui::Text("Tile cache hit rate: %.2f%% (%llu decoded rows)", total ? 100.0 * hits / total : 0.0, (unsigned long long)total);
 
 	ImGui::End();
 }
@@ -63,9 +67,10 @@ void PatternTableViewer::DecodePatternTable(int index, std::vector<Color>& buffe
 {
 	// uint8_t stride = 128;
 	Word baseAddr = (Word)(0x1000 * index);
-	if (baseAddr >= mapper->CHR_ROM.size())
+	if (baseAddr >= mapper->CHR_ROM->size())
 		return;
 
+	TileCache& tileCache = mapper->GetTileCache();
 	for (uint8_t y = 0; y < 16; y++)
 	{
 		for (uint8_t x = 0; x < 16; x++)
@@ -74,17 +79,12 @@ void PatternTableViewer::DecodePatternTable(int index, std::vector<Color>& buffe
 			
 			for(int l = 0; l < 8; l++)
 			{
-				uint8_t loColor = mapper->CHR_ROM[tileAddress + l];
-				uint8_t hiColor = mapper->CHR_ROM[tileAddress + 8 + l];
+				const TileCache::Row& row = tileCache.GetRow(tileAddress + l);
 
 				for (int k = 0; k < 8; k++)
 				{
-					uint8_t color = ((loColor & 0x80) >> 7) | ((hiColor & 0x80) >> 6);
-					color *= 80;
+					uint8_t color = row[k] * 80;
 					buffer[(y * 8 + l) * 128 + (x * 8 + k)] = Color{ color, color, color };
-
-					loColor <<= 1;
-					hiColor <<= 1;
 				}
 			}
 		}
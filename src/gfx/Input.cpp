@@ -1,9 +1,32 @@
 #include "Window.hpp"
 #include "Input.hpp"
 
-Window* Input::window = nullptr;
+#include "../controllers/StandardController.hpp"
 
-bool Input::IsKeyDown(int key)
+KeyboardInput::KeyboardInput(Window* window) :
+	window(window)
+{
+}
+
+bool KeyboardInput::IsKeyDown(int key)
 {
 	return (glfwGetKey(window->GetNativeWindow(), key) == GLFW_PRESS);
 }
+
+InputState KeyboardInput::Sample()
+{
+	StandardButtons pressed;
+
+	pressed.Buttons.A		= IsKeyDown(GLFW_KEY_L);
+	pressed.Buttons.B		= IsKeyDown(GLFW_KEY_K);
+	pressed.Buttons.Select	= IsKeyDown(GLFW_KEY_RIGHT_SHIFT);
+	pressed.Buttons.Start	= IsKeyDown(GLFW_KEY_ENTER);
+	pressed.Buttons.Up		= IsKeyDown(GLFW_KEY_W);
+	pressed.Buttons.Down	= IsKeyDown(GLFW_KEY_S);
+	pressed.Buttons.Left	= IsKeyDown(GLFW_KEY_A);
+	pressed.Buttons.Right	= IsKeyDown(GLFW_KEY_D);
+
+	InputState state;
+	state.Ports[0] = pressed.Raw;
+	return state;
+}
@@ -3,14 +3,24 @@
 #include <memory>
 #include <GLFW/glfw3.h>
 
+#include "../InputSource.hpp"
+
 class Window;
 
-class Input
+/**
+ * @brief Maps the keyboard of a window to the first controller.
+ */
+class KeyboardInput :
+	public InputSource
 {
 public:
-	static inline void SetWindow(Window* source) { window = source; }
-	static bool IsKeyDown(int key);
+	KeyboardInput(Window* window);
+
+	virtual InputState Sample();
+
+private:
+	bool IsKeyDown(int key);
 
 private:
-	static Window* window;
+	Window* window;
 };
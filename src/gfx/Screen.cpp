@@ -5,10 +5,11 @@
 #include <stdexcept>
 
 #include "../Log.hpp"
+#include "../PPU.hpp"
 
 Screen::Screen()
 {
-	pixels.resize(256 * 240);
+	rgbPixels.resize(256 * 240);
 
 	LOG_CORE_INFO("Creating vertex arrays");
 	CreateVertexArray();
@@ -28,14 +29,13 @@ Screen::~Screen()
 	glDeleteVertexArrays(1, &vao);
 }
 
-void Screen::SetPixel(uint16_t x, uint16_t y, Color color)
-{
-	pixels[y * 256 + x] = color;
-}
-
 void Screen::Render()
 {
-	glTextureSubImage2D(texture, 0, 0, 0, 256, 240, GL_RGB, GL_UNSIGNED_BYTE, (const void*)pixels.data());
+	// The color table has no emphasized colors, so the emphasis bits are ignored here
+	for (size_t i = 0; i < pixels.size(); i++)
+		rgbPixels[i] = PPU::colorTable[pixels[i] & 0x3F];
+
+	glTextureSubImage2D(texture, 0, 0, 0, 256, 240, GL_RGB, GL_UNSIGNED_BYTE, (const void*)rgbPixels.data());
 
 	glBindTexture(GL_TEXTURE_2D, texture);
 	glUseProgram(shader);
@@ -3,14 +3,21 @@
 #include <cstdint>
 #include <vector>
 #include "../Types.hpp"
+#include "../FrameSink.hpp"
 
-class Screen
+/**
+ * @brief Displays the frames of the emulator in the window.
+ */
+class Screen :
+	public FrameSink
 {
 public:
 	Screen();
 	~Screen();
 
-	void SetPixel(uint16_t x, uint16_t y, Color color);
+	/**
+	 * @brief Convert the frame to RGB and draw it.
+	 */
 	void Render();
 
 private:
@@ -24,5 +31,5 @@ private:
 	uint32_t vao = 0;
 	uint32_t vbo = 0;
 
-	std::vector<Color> pixels;
+	std::vector<Color> rgbPixels;
 };
@@ -5,8 +5,6 @@
 #include <imgui/backends/imgui_impl_opengl3.h>
 #include <imgui/imgui.h>
 
-#include "Input.hpp"
-
 Window::Window(uint16_t width, uint16_t height, const std::string& title) :
 	handle(nullptr)
 {
@@ -22,7 +20,6 @@ Window::Window(uint16_t width, uint16_t height, const std::string& title) :
 
 	glfwMakeContextCurrent(handle);
 	glfwSwapInterval(0);
-	Input::SetWindow(this);
 }
 
 Window::~Window()
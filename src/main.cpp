@@ -1,16 +1,73 @@
+#include <cstring>
+#include <cstdlib>
+
 #include "Application.hpp"
+#include "HeadlessRunner.hpp"
 #include "Log.hpp"
 
 int main(int argc, char** argv)
 {
 	Log::Init();
-	
-	if (argc != 2) {
-		LOG_CORE_FATAL("Usage: {0} <rom>", argv[0]);
+
+	const char* rom = nullptr;
+	bool headless = false;
+	bool valid = true;
+	bool headlessOptions = false;
+	HeadlessRunner::Options options;
+	size_t instances = 1;
+	size_t threads = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		// Every option besides --headless itself only applies to headless runs
+		headlessOptions |= (argv[i][0] == '-' && strcmp(argv[i], "--headless") != 0);
+
+		if (strcmp(argv[i], "--headless") == 0)
+			headless = true;
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			options.Frames = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--hash-file") == 0 && i + 1 < argc)
+			options.HashFile = argv[++i];
+		else if (strcmp(argv[i], "--run-ahead") == 0 && i + 1 < argc)
+			options.RunAheadFrames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--renderer") == 0 && i + 1 < argc)
+		{
+			const char* renderer = argv[++i];
+			options.ScanlineRenderer = (strcmp(renderer, "scanline") == 0);
+			valid &= options.ScanlineRenderer || strcmp(renderer, "dot") == 0;
+		}
+		else if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc)
+			instances = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = strtoull(argv[++i], nullptr, 10);
+		else if (rom == nullptr && argv[i][0] != '-')
+			rom = argv[i];
+		else
+			valid = false;
+	}
+
+	// The window would silently ignore them
+	valid &= headless || !headlessOptions;
+
+	if (!valid || rom == nullptr || instances == 0) {
+		LOG_CORE_FATAL("Usage: {0} [--headless [--frames <n>] [--hash-file <file>] [--run-ahead <n>] [--renderer dot|scanline] [--instances <n> [--threads <n>]]] <rom>", argv[0]);
+		return -1;
+	}
+
+	// Parallel instances only report their speed, they don't write hashes or run ahead
+	if (instances > 1 && (options.HashFile != nullptr || options.RunAheadFrames != 0))
+	{
+		LOG_CORE_FATAL("--instances can't be combined with --hash-file or --run-ahead");
 		return -1;
 	}
 
-	Application::Launch(argv[1]);
+	if (headless && instances > 1)
+		return HeadlessRunner::LaunchParallel(rom, options, instances, threads);
+
+	if (headless)
+		return HeadlessRunner::Launch(rom, options);
+
+	Application::Launch(rom);
 
 	return 0;
 }
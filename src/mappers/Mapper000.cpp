@@ -8,32 +8,26 @@ Mapper000::Mapper000(const Header& header, std::ifstream& ifs) :
 	Mapper(header)
 {
 	LOG_CORE_INFO("Allocating PRG ROM");
-	PRG_ROM = std::vector<Byte>(0x4000 * prgBanks);
-	ifs.read((char*)PRG_ROM.data(), 0x4000 * prgBanks);
+	auto prg = std::make_shared<std::vector<Byte>>(0x4000 * prgBanks);
+	ifs.read((char*)prg->data(), 0x4000 * prgBanks);
+	PRG_ROM = prg;
 
-	LOG_CORE_INFO("Allocating CHR ROM");
-	CHR_ROM = std::vector<Byte>(0x2000);
-	ifs.read((char*)CHR_ROM.data(), 0x2000);
-}
+	// With only one bank, it is mirrored to $C000-$FFFF
+	for (uint32_t addr = 0x8000; addr <= 0xFFFF; addr += 0x100)
+		MapPRGPage(addr, addr & (0x4000 * prgBanks - 1));
 
-Byte Mapper000::ReadCPU(Word addr)
-{
-	if (0x8000 <= addr && addr <= 0xFFFF)
-	{
-		return PRG_ROM[addr & (0x4000 * prgBanks - 1)];
-	}
+	LOG_CORE_INFO("Allocating CHR ROM");
+	CHR_ROM = std::make_shared<std::vector<Byte>>(0x2000);
+	ifs.read((char*)CHR_ROM->data(), 0x2000);
+	tileCache.Reset(*CHR_ROM);
 
-	return 0x00;
+	for (Word addr = 0x0000; addr < 0x2000; addr += 0x400)
+		MapCHRPage(addr, addr);
 }
 
-Byte Mapper000::ReadPPU(Word addr)
+Mapper* Mapper000::Clone() const
 {
-	if (0x0000 <= addr && addr <= 0x1FFF)
-	{
-		return CHR_ROM[addr];
-	}
-
-	return 0x00;
+	return new Mapper000(*this);
 }
 
 void Mapper000::WriteCPU(Word, Byte)
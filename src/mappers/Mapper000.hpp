@@ -11,8 +11,8 @@ class Mapper000 :
 public:
 	Mapper000(const Header& header, std::ifstream& ifs);
 
-	virtual Byte ReadCPU(Word addr) override;
-	virtual Byte ReadPPU(Word addr) override;
+	virtual Mapper* Clone() const override;
+
 	virtual void WriteCPU(Word addr, Byte val) override;
 	virtual void WritePPU(Word addr, Byte val) override;
 };
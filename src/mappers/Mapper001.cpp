@@ -4,20 +4,50 @@ Mapper001::Mapper001(const Header& header, std::ifstream& ifs) :
 	Mapper(header)
 {
 	LOG_CORE_INFO("Allocating PRG ROM");
-	PRG_ROM = std::vector<Byte>(0x4000 * prgBanks);
-	ifs.read((char*)PRG_ROM.data(), 0x4000 * prgBanks);
+	auto prg = std::make_shared<std::vector<Byte>>(0x4000 * prgBanks);
+	ifs.read((char*)prg->data(), 0x4000 * prgBanks);
+	PRG_ROM = prg;
+	MapPRG();
 
-	LOG_CORE_INFO("Allocating CHR ROM");
-	CHR_ROM = std::vector<Byte>(0x2000 * chrBanks);
-	ifs.read((char*)CHR_ROM.data(), 0x2000 * chrBanks);
+	// Boards without CHR ROM have 8KB of CHR RAM instead
+	if (chrBanks == 0)
+	{
+		LOG_CORE_INFO("Allocating CHR RAM");
+		CHR_ROM = std::make_shared<std::vector<Byte>>(0x2000);
+		chrRAM = true;
+	}
+	else
+	{
+		LOG_CORE_INFO("Allocating CHR ROM");
+		CHR_ROM = std::make_shared<std::vector<Byte>>(0x2000 * chrBanks);
+		ifs.read((char*)CHR_ROM->data(), 0x2000 * chrBanks);
+	}
+
+	tileCache.Reset(*CHR_ROM);
+	MapCHR();
+}
+
+Mapper* Mapper001::Clone() const
+{
+	Mapper001* clone = new Mapper001(*this);
+
+	// CHR RAM is written by the game, so it can't be shared like the ROM
+	if (chrRAM)
+	{
+		clone->CHR_ROM = std::make_shared<std::vector<Byte>>(*CHR_ROM);
+		clone->tileCache.Reset(*clone->CHR_ROM);
+	}
+
+	return clone;
 }
 
-Byte Mapper001::ReadCPU(Word addr)
+void Mapper001::MapPRG()
 {
-	if (0x8000 <= addr && addr <= 0xFFFF)
+	Byte prgControl = (control >> 2) & 0x3;
+
+	for (uint32_t addr = 0x8000; addr <= 0xFFFF; addr += 0x100)
 	{
 		Byte selectedBank = prgBank;
-		Byte prgControl = (control >> 2) & 0x3;
 
 		switch (prgControl)
 		{
@@ -36,19 +66,25 @@ Byte Mapper001::ReadCPU(Word addr)
 			break;
 		}
 
-		return PRG_ROM[(addr & (0x4000 * selectedBank - 1)) & 0x7FFF];
+		MapPRGPage(addr, (addr & (0x4000 * selectedBank - 1)) & 0x7FFF);
 	}
 
-	return 0x00;
+	PRGBanksSwitched();
 }
 
-Byte Mapper001::ReadPPU(Word addr)
+void Mapper001::MapCHR()
 {
-	if (0x0000 <= addr && addr <= 0x1FFF)
+	Byte chrControl = (control >> 4) & 0x1;
+
+	for (Word addr = 0x0000; addr < 0x2000; addr += 0x400)
 	{
-		Byte selectedBank = 0x00;
-		Byte chrControl = (control >> 4) & 0x1;
+		if (chrRAM)
+		{
+			MapCHRPage(addr, addr);
+			continue;
+		}
 
+		Byte selectedBank = 0x00;
 		if (chrControl)
 		{
 			if (addr < 0x1000)
@@ -61,10 +97,8 @@ Byte Mapper001::ReadPPU(Word addr)
 			selectedBank = chrBank0 & ~0x1;
 		}
 
-		return CHR_ROM[addr & (0x1000 * selectedBank - 1)];
+		MapCHRPage(addr, addr & (0x1000 * selectedBank - 1));
 	}
-
-	return 0x00;
 }
 
 void Mapper001::WriteCPU(Word addr, Byte val)
@@ -75,6 +109,7 @@ void Mapper001::WriteCPU(Word addr, Byte val)
 		{
 			shiftRegister = 0x00;
 			control |= 0x0C;
+			MapPRG();
 			return;
 		}
 
@@ -93,14 +128,25 @@ void Mapper001::WriteCPU(Word addr, Byte val)
 			case 3:	prgBank		= shiftRegister; break;
 			}
 
+			if (registerSelect == 0 || registerSelect == 3)
+				MapPRG();
+
+			if (registerSelect != 3)
+				MapCHR();
+
 			shiftRegister = 0x00;
 			latch = 0;
 		}
 	}
 }
 
-void Mapper001::WritePPU(Word, Byte)
+void Mapper001::WritePPU(Word addr, Byte val)
 {
+	if (chrRAM && addr <= 0x1FFF)
+	{
+		(*CHR_ROM)[addr] = val;
+		tileCache.Invalidate(addr);
+	}
 }
 
 bool Mapper001::MapCIRAM(Word& addr)
@@ -123,3 +169,35 @@ bool Mapper001::MapCIRAM(Word& addr)
 
 	return false;
 }
+
+void Mapper001::Serialize(SaveState& state) const
+{
+	state.Write(latch);
+	state.Write(shiftRegister);
+	state.Write(control);
+	state.Write(chrBank0);
+	state.Write(chrBank1);
+	state.Write(prgBank);
+
+	if (chrRAM)
+		state.WriteBytes(CHR_ROM->data(), CHR_ROM->size());
+}
+
+void Mapper001::Deserialize(SaveState& state)
+{
+	state.Read(latch);
+	state.Read(shiftRegister);
+	state.Read(control);
+	state.Read(chrBank0);
+	state.Read(chrBank1);
+	state.Read(prgBank);
+
+	if (chrRAM)
+	{
+		state.ReadBytes(CHR_ROM->data(), CHR_ROM->size());
+		tileCache.Reset(*CHR_ROM);
+	}
+
+	MapPRG();
+	MapCHR();
+}
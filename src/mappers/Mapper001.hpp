@@ -9,13 +9,27 @@ class Mapper001 :
 public:
 	Mapper001(const Header& header, std::ifstream& ifs);
 
-	virtual Byte ReadCPU(Word addr) override;
-	virtual Byte ReadPPU(Word addr) override;
+	virtual Mapper* Clone() const override;
+
 	virtual void WriteCPU(Word addr, Byte val) override;
 	virtual void WritePPU(Word addr, Byte val) override;
 	
 	virtual bool MapCIRAM(Word& addr) override;
 
+	virtual void Serialize(SaveState& state) const override;
+	virtual void Deserialize(SaveState& state) override;
+
+private:
+	/**
+	 * @brief Update the PRG page table after a register changed.
+	 */
+	void MapPRG();
+
+	/**
+	 * @brief Update the CHR page table after a register changed.
+	 */
+	void MapCHR();
+
 private:
 	Byte latch = 0;
 
@@ -24,4 +38,6 @@ private:
 	Byte chrBank0 = 0x00;
 	Byte chrBank1 = 0x00;
 	Byte prgBank = 0x00;
+
+	bool chrRAM = false;
 };
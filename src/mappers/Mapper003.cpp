@@ -7,32 +7,30 @@ Mapper003::Mapper003(const Header& header, std::ifstream& ifs) :
 	Mapper(header)
 {
 	LOG_CORE_INFO("Allocating PRG ROM");
-	PRG_ROM = std::vector<Byte>(0x4000 * prgBanks);
-	ifs.read((char*)PRG_ROM.data(), 0x4000 * prgBanks);
+	auto prg = std::make_shared<std::vector<Byte>>(0x4000 * prgBanks);
+	ifs.read((char*)prg->data(), 0x4000 * prgBanks);
+	PRG_ROM = prg;
+
+	// With only one bank, it is mirrored to $C000-$FFFF
+	for (uint32_t addr = 0x8000; addr <= 0xFFFF; addr += 0x100)
+		MapPRGPage(addr, addr & (0x4000 * prgBanks - 1));
 
 	LOG_CORE_INFO("Allocating CHR ROM");
-	CHR_ROM = std::vector<Byte>(0x2000 * chrBanks);
-	ifs.read((char*)CHR_ROM.data(), 0x2000 * chrBanks);
+	CHR_ROM = std::make_shared<std::vector<Byte>>(0x2000 * chrBanks);
+	ifs.read((char*)CHR_ROM->data(), 0x2000 * chrBanks);
+	tileCache.Reset(*CHR_ROM);
+	MapCHR();
 }
 
-Byte Mapper003::ReadCPU(Word addr)
+Mapper* Mapper003::Clone() const
 {
-	if (0x8000 <= addr && addr <= 0xFFFF)
-	{
-		return PRG_ROM[addr & (0x4000 * prgBanks - 1)];
-	}
-
-	return 0x00;
+	return new Mapper003(*this);
 }
 
-Byte Mapper003::ReadPPU(Word addr)
+void Mapper003::MapCHR()
 {
-	if (0x0000 <= addr && addr <= 0x1FFF)
-	{
-		return CHR_ROM[0x2000 * selectedChrBank + addr];
-	}
-
-	return 0x00;
+	for (Word addr = 0x0000; addr < 0x2000; addr += 0x400)
+		MapCHRPage(addr, 0x2000 * selectedChrBank + addr);
 }
 
 void Mapper003::WriteCPU(Word addr, Byte val)
@@ -40,9 +38,21 @@ void Mapper003::WriteCPU(Word addr, Byte val)
 	if (0x8000 <= addr && addr <= 0xFFFF)
 	{
 		selectedChrBank = val & 0x3;
+		MapCHR();
 	}
 }
 
 void Mapper003::WritePPU(Word, Byte)
 {
 }
+
+void Mapper003::Serialize(SaveState& state) const
+{
+	state.Write(selectedChrBank);
+}
+
+void Mapper003::Deserialize(SaveState& state)
+{
+	state.Read(selectedChrBank);
+	MapCHR();
+}
@@ -11,11 +11,20 @@ class Mapper003 :
 public:
 	Mapper003(const Header& header, std::ifstream& ifs);
 
-	virtual Byte ReadCPU(Word addr) override;
-	virtual Byte ReadPPU(Word addr) override;
+	virtual Mapper* Clone() const override;
+
 	virtual void WriteCPU(Word addr, Byte val) override;
 	virtual void WritePPU(Word addr, Byte val) override;
 
+	virtual void Serialize(SaveState& state) const override;
+	virtual void Deserialize(SaveState& state) override;
+
+private:
+	/**
+	 * @brief Update the CHR page table after a bank switch.
+	 */
+	void MapCHR();
+
 private:
 	Byte selectedChrBank = 0;
 };
@@ -0,0 +1,114 @@
+// Runs a ROM on a reference machine and on machines that were cloned, restored from a snapshot
+// or are driven through run-ahead, and compares the whole machine state after every frame.
+//
+// Usage: lockstep <rom> <frames>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "Bus.hpp"
+#include "FrameSink.hpp"
+#include "RunAhead.hpp"
+#include "SaveState.hpp"
+
+struct Machine
+{
+	const char* Name;
+	std::unique_ptr<FrameSink> Screen;
+	std::unique_ptr<Bus> Emulator;
+	std::unique_ptr<RunAhead> Runner;	//< Drives the machine if set
+	bool ComparePixels;					//< Run-ahead shows other frames, restored machines miss the first one
+};
+
+// Buttons that change every few frames, so games leave their title screens
+static InputState InputForFrame(uint64_t frame)
+{
+	static const Byte buttons[] = { 0x10, 0x00, 0x01, 0x81, 0x00, 0x02, 0x42, 0x08, 0x04 };
+
+	InputState state;
+	state.Ports[0] = buttons[(frame / 20) % (sizeof(buttons) / sizeof(buttons[0]))];
+	return state;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <rom> <frames>\n", argv[0]);
+		return 2;
+	}
+
+	const char* rom = argv[1];
+	uint64_t frames = strtoull(argv[2], nullptr, 10);
+
+	FrameSink referenceScreen;
+	Bus reference(rom, &referenceScreen);
+
+	std::vector<Machine> machines;
+	auto add = [&](const char* name, std::unique_ptr<FrameSink> screen, std::unique_ptr<Bus> emulator, uint32_t runAhead, bool comparePixels)
+	{
+		std::unique_ptr<RunAhead> runner = runAhead ? std::make_unique<RunAhead>(emulator.get(), runAhead) : nullptr;
+		machines.push_back({ name, std::move(screen), std::move(emulator), std::move(runner), comparePixels });
+	};
+
+	auto screen = std::make_unique<FrameSink>();
+	auto emulator = std::make_unique<Bus>(rom, screen.get());
+	add("run-ahead", std::move(screen), std::move(emulator), 2, false);
+
+	SaveState expected, actual;
+	for (uint64_t frame = 0; frame < frames; frame++)
+	{
+		// A fork of the reference machine, and a new one started from its state
+		if (frame == frames / 3)
+		{
+			screen = std::make_unique<FrameSink>();
+			emulator = reference.Clone(screen.get());
+			add("clone", std::move(screen), std::move(emulator), 0, true);
+		}
+
+		if (frame == frames / 2)
+		{
+			screen = std::make_unique<FrameSink>();
+			emulator = std::make_unique<Bus>(rom, screen.get());
+			reference.Snapshot(expected);
+			emulator->Restore(expected);
+			add("restored", std::move(screen), std::move(emulator), 0, false);
+		}
+
+		InputState input = InputForFrame(frame);
+		reference.SetInput(input);
+		reference.Frame();
+		reference.Snapshot(expected);
+
+		for (Machine& machine : machines)
+		{
+			machine.Emulator->SetInput(input);
+			if (machine.Runner)
+				machine.Runner->Frame();
+			else
+				machine.Emulator->Frame();
+
+			machine.Emulator->Snapshot(actual);
+			if (actual.GetData() != expected.GetData())
+			{
+				size_t offset = 0;
+				while (offset < actual.GetSize() && offset < expected.GetSize() && actual.GetData()[offset] == expected.GetData()[offset])
+					offset++;
+
+				printf("FAIL: %s differs from the reference after frame %llu (state byte %zu)\n", machine.Name, (unsigned long long)frame, offset);
+				return 1;
+			}
+
+			if (machine.ComparePixels && machine.Screen->GetPixels() != referenceScreen.GetPixels())
+			{
+				printf("FAIL: %s drew a different frame %llu\n", machine.Name, (unsigned long long)frame);
+				return 1;
+			}
+		}
+	}
+
+	printf("OK: %zu machines in lockstep with the reference for %llu frames\n", machines.size(), (unsigned long long)frames);
+	return 0;
+}
@@ -0,0 +1,97 @@
+// Runs a ROM forward and backward with the rewinder, and checks that every step back lands
+// on the state of the frame before, also after the emulation was resumed in between.
+//
+// Usage: rewind <rom> <frames>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Bus.hpp"
+#include "FrameSink.hpp"
+#include "Rewinder.hpp"
+#include "SaveState.hpp"
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <rom> <frames>\n", argv[0]);
+		return 2;
+	}
+
+	const char* rom = argv[1];
+	uint64_t frames = strtoull(argv[2], nullptr, 10);
+
+	// Without input the machine takes the same path every time it runs a frame again
+	FrameSink referenceScreen;
+	Bus reference(rom, &referenceScreen);
+	std::vector<SaveState> states(frames);
+	for (SaveState& state : states)
+	{
+		reference.Frame();
+		reference.Snapshot(state);
+	}
+
+	FrameSink screen;
+	Bus bus(rom, &screen);
+	Rewinder rewinder(64 * 1024 * 1024);
+
+	uint64_t frame = 0;	// Index of the state the machine is in
+	auto check = [&](const char* step) -> bool
+	{
+		SaveState actual;
+		bus.Snapshot(actual);
+		if (actual.GetData() == states[frame].GetData())
+			return true;
+
+		printf("FAIL: the machine isn't in the state of frame %llu after %s\n", (unsigned long long)frame, step);
+		return false;
+	};
+
+	auto forward = [&](uint64_t count) -> bool
+	{
+		for (uint64_t i = 0; i < count; i++)
+		{
+			bus.Frame();
+			rewinder.Push(bus);
+
+			frame++;
+			if (!check("running a frame"))
+				return false;
+		}
+
+		return true;
+	};
+
+	auto back = [&](uint64_t count) -> bool
+	{
+		for (uint64_t i = 0; i < count; i++)
+		{
+			if (!rewinder.StepBack(bus))
+			{
+				printf("FAIL: no state left to step back to from frame %llu\n", (unsigned long long)frame);
+				return false;
+			}
+
+			frame--;
+			if (!check("stepping back"))
+				return false;
+		}
+
+		return true;
+	};
+
+	// Forward to the end, back a bit, forward again and then further back than the first time
+	bus.Frame();
+	rewinder.Push(bus);
+	if (!check("the first frame"))
+		return 1;
+
+	uint64_t steps = frames / 4;
+	if (!forward(frames - 1 - steps) || !back(steps) || !forward(steps / 2) || !back(2 * steps) || !forward(steps))
+		return 1;
+
+	printf("OK: rewinding stayed on the reference states for %llu frames\n", (unsigned long long)frames);
+	return 0;
+}
@@ -0,0 +1,203 @@
+// Restores a snapshot, in memory and through a file, and checks that the machine draws the
+// same frames afterwards. Broken states have to be rejected without changing the machine.
+//
+// Usage: savestate <rom> <frames>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Bus.hpp"
+#include "FrameSink.hpp"
+#include "HeadlessRunner.hpp"
+#include "SaveState.hpp"
+
+// Buttons that change every few frames, so games leave their title screens
+static InputState InputForFrame(uint64_t frame)
+{
+	static const Byte buttons[] = { 0x10, 0x00, 0x01, 0x81, 0x00, 0x02, 0x42, 0x08, 0x04 };
+
+	InputState state;
+	state.Ports[0] = buttons[(frame / 20) % (sizeof(buttons) / sizeof(buttons[0]))];
+	return state;
+}
+
+// Hashes of the frames drawn from the given frame on
+static std::vector<uint32_t> RunFrames(Bus& bus, FrameSink& screen, uint64_t from, uint64_t to)
+{
+	std::vector<uint32_t> hashes;
+	for (uint64_t frame = from; frame < to; frame++)
+	{
+		bus.SetInput(InputForFrame(frame));
+		bus.Frame();
+		hashes.push_back(HeadlessRunner::HashFrame(screen.GetPixels()));
+	}
+
+	return hashes;
+}
+
+// Restore a broken state, which has to be rejected without touching the machine
+static bool Rejects(Bus& bus, SaveState& broken, const char* what)
+{
+	SaveState before, after;
+	bus.Snapshot(before);
+
+	try
+	{
+		bus.Restore(broken);
+	}
+	catch (const std::runtime_error&)
+	{
+		bus.Snapshot(after);
+		if (after.GetData() == before.GetData())
+			return true;
+
+		printf("FAIL: the machine changed after rejecting a state (%s)\n", what);
+		return false;
+	}
+
+	printf("FAIL: a broken state was accepted (%s)\n", what);
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <rom> <frames>\n", argv[0]);
+		return 2;
+	}
+
+	const char* rom = argv[1];
+	uint64_t frames = strtoull(argv[2], nullptr, 10);
+	uint64_t saved = frames / 2;
+
+	FrameSink screen;
+	Bus bus(rom, &screen);
+	RunFrames(bus, screen, 0, saved);
+
+	// Save in the middle of a frame, so the PPU and the scheduler aren't at their usual spots
+	for (int i = 0; i < 1000; i++)
+		bus.Instruction();
+
+	SaveState state;
+	bus.Snapshot(state);
+	std::vector<uint32_t> expected = RunFrames(bus, screen, saved, frames);
+	SaveState expectedEnd;
+	bus.Snapshot(expectedEnd);
+
+	// The frame buffer isn't saved, so the top of the first frame after restoring is left over
+	bus.Restore(state);
+	std::vector<uint32_t> restored = RunFrames(bus, screen, saved, frames);
+	if (!std::equal(restored.begin() + 1, restored.end(), expected.begin() + 1))
+	{
+		printf("FAIL: the restored machine drew different frames\n");
+		return 1;
+	}
+
+	SaveState end;
+	bus.Snapshot(end);
+	if (end.GetData() != expectedEnd.GetData())
+	{
+		printf("FAIL: the restored machine ended in a different state\n");
+		return 1;
+	}
+
+	std::string path = (std::filesystem::temp_directory_path() / "savestate_test.state").string();
+	state.SaveToFile(path);
+
+	SaveState loaded;
+	loaded.LoadFromFile(path);
+	std::filesystem::remove(path);
+
+	FrameSink otherScreen;
+	Bus other(rom, &otherScreen);
+	other.Restore(loaded);
+
+	std::vector<uint32_t> fromFile = RunFrames(other, otherScreen, saved, frames);
+	if (!std::equal(fromFile.begin() + 1, fromFile.end(), expected.begin() + 1))
+	{
+		printf("FAIL: the machine restored from a file drew different frames\n");
+		return 1;
+	}
+
+	other.Snapshot(end);
+	if (end.GetData() != expectedEnd.GetData())
+	{
+		printf("FAIL: the machine restored from a file ended in a different state\n");
+		return 1;
+	}
+
+	// Every truncation and trailing data
+	SaveState broken;
+	for (size_t size = 0; size < state.GetSize(); size++)
+	{
+		broken.GetData().assign(state.GetData().begin(), state.GetData().begin() + size);
+		if (!Rejects(bus, broken, "truncated"))
+			return 1;
+	}
+
+	broken.GetData() = state.GetData();
+	broken.GetData().push_back(0);
+	if (!Rejects(bus, broken, "trailing data"))
+		return 1;
+
+	// The state ends with the scheduler's events and four clocks
+	const size_t clocks = 4 * sizeof(uint64_t);
+	const size_t eventSize = sizeof(uint64_t) + sizeof(Byte);
+	size_t events = 0;
+	for (uint32_t count = 1; count <= 16; count++)
+	{
+		size_t offset = state.GetSize() - clocks - count * eventSize - sizeof(uint32_t);
+		uint32_t value;
+		memcpy(&value, state.GetData().data() + offset, sizeof(value));
+		if (value == count)
+			events = offset;
+	}
+
+	broken.GetData() = state.GetData();
+	broken.GetData()[state.GetSize() - clocks - 1] = 0x7F;
+	if (!Rejects(bus, broken, "scheduler event type"))
+		return 1;
+
+	broken.GetData() = state.GetData();
+	broken.GetData()[events] = 0xFF;
+	if (!Rejects(bus, broken, "scheduler event count"))
+		return 1;
+
+	// Flags and enums only allow a few values, so most of them reject a byte set to 0xFF
+	size_t rejected = 0;
+	for (size_t offset = 0; offset < events; offset++)
+	{
+		broken.GetData() = state.GetData();
+		broken.GetData()[offset] = 0xFF;
+
+		try
+		{
+			bus.Restore(broken);
+		}
+		catch (const std::runtime_error&)
+		{
+			SaveState after;
+			bus.Snapshot(after);
+			if (after.GetData() != end.GetData())
+			{
+				printf("FAIL: the machine changed after rejecting a state (byte %zu)\n", offset);
+				return 1;
+			}
+
+			rejected++;
+			continue;
+		}
+
+		bus.Restore(end);
+	}
+
+	printf("OK: %llu frames match after restoring, %zu corrupted bytes rejected\n", (unsigned long long)(frames - saved), rejected);
+	return 0;
+}
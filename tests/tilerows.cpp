@@ -0,0 +1,60 @@
+// Checks the tile row expansion of TileCache against the plain bit shifter, for every
+// combination of the two bit planes.
+//
+// Usage: tilerows
+
+#include <cstdio>
+#include <vector>
+
+#include "TileCache.hpp"
+
+// Pixel i the way the hardware shifters produce it, leftmost pixel first
+static Byte ShiftPixel(Byte lo, Byte hi, int i)
+{
+	return (Byte)((((hi >> (7 - i)) & 1) << 1) | ((lo >> (7 - i)) & 1));
+}
+
+int main()
+{
+	// Lay out every combination as a row of CHR memory, 8 rows to a tile
+	std::vector<Byte> chr(0x10000 * 2);
+	for (unsigned int planes = 0; planes < 0x10000; planes++)
+	{
+		size_t offset = ((planes >> 3) << 4) | (planes & 0x7);
+		chr[offset] = (Byte)planes;
+		chr[offset + 8] = (Byte)(planes >> 8);
+	}
+
+	TileCache cache;
+	cache.Reset(chr);
+
+	unsigned int failures = 0;
+	for (unsigned int planes = 0; planes < 0x10000; planes++)
+	{
+		Byte lo = (Byte)planes;
+		Byte hi = (Byte)(planes >> 8);
+
+		TileCache::Row expected;
+		for (int i = 0; i < 8; i++)
+			expected[i] = ShiftPixel(lo, hi, i);
+
+		TileCache::Row unpacked;
+		uint64_t packed = TileCache::ExpandPlanes(lo, hi);
+		TileCache::Unpack(packed, unpacked.data());
+
+		const TileCache::Row& decoded = cache.GetRow(((planes >> 3) << 4) | (planes & 0x7));
+
+		bool ok = (unpacked == expected) && (TileCache::Pack(expected) == packed) && (decoded == expected);
+		if (!ok && failures++ < 8)
+			printf("FAIL: lo %02x hi %02x expanded to %016llx\n", lo, hi, (unsigned long long)packed);
+	}
+
+	if (failures)
+	{
+		printf("FAIL: %u of 65536 plane combinations differ from the shifter\n", failures);
+		return 1;
+	}
+
+	printf("OK: all 65536 plane combinations match the shifter\n");
+	return 0;
+}